@@ -0,0 +1,139 @@
+// bbp_digits.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "bbp_digits.hpp"
+#include <cmath>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+/**
+ * Computes a * b mod modulus without overflow
+ * Products of residues below 2^32 fit in 64 bits; larger moduli use 128-bit arithmetic
+ * where the compiler has it (not on 32-bit targets such as the Wii) and shift-and-add otherwise
+ * @param a The first factor (below modulus)
+ * @param b The second factor (below modulus)
+ * @param modulus The modulus
+ * @return The residue of the product
+ */
+static uint64_t multiply_mod(uint64_t a, uint64_t b, uint64_t modulus)
+{
+  if (modulus <= UINT32_MAX)
+  {
+    return a * b % modulus;
+  }
+#ifdef __SIZEOF_INT128__
+  return static_cast<uint64_t>(static_cast<__uint128_t>(a) * b % modulus);
+#else
+  uint64_t result = 0;
+  while (b)
+  {
+    if (b & 1)
+    {
+      result = (result >= modulus - a) ? result - (modulus - a) : result + a;
+    }
+    a = (a >= modulus - a) ? a - (modulus - a) : a + a;
+    b >>= 1;
+  }
+  return result;
+#endif
+}
+
+/**
+ * Computes 16^exponent mod modulus by square-and-multiply
+ * @param exponent The exponent
+ * @param modulus The modulus
+ * @return The residue
+ */
+static uint64_t power_of_16_mod(uint64_t exponent, uint64_t modulus)
+{
+  uint64_t result = 1 % modulus;
+  uint64_t base = 16 % modulus;
+  while (exponent)
+  {
+    if (exponent & 1)
+    {
+      result = multiply_mod(result, base, modulus);
+    }
+    base = multiply_mod(base, base, modulus);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+/**
+ * Returns the fractional part of sum_k 16^(d-k) / (8k+j), the building block of BBP digit extraction
+ * @param d The position before the first wanted digit
+ * @param j The offset in the denominator (1, 4, 5 or 6)
+ * @return The fractional part of the series
+ */
+static double bbp_series(uint64_t d, uint64_t j)
+{
+  double sum = 0;
+
+  // Terms up to d: only the fractional part of each matters, so 16^(d-k) is reduced mod 8k+j
+  for (uint64_t k = 0; k <= d; ++k)
+  {
+    uint64_t denominator = 8 * k + j;
+    sum += static_cast<double>(power_of_16_mod(d - k, denominator)) / denominator;
+    sum -= floor(sum);
+  }
+
+  // The tail beyond d shrinks by 16 per term
+  double power = 1.0 / 16;
+  for (uint64_t k = d + 1; power > 1e-17; ++k)
+  {
+    sum += power / (8 * k + j);
+    power /= 16;
+  }
+  return sum - floor(sum);
+}
+
+/**
+ * Returns the work of a BBP extraction at a position in modular multiplication steps:
+ * one exponentiation per term up to the position, each with about log2(position) steps
+ * @param position The position of the first digit
+ * @return The number of steps
+ */
+double bbp_steps(uint64_t position)
+{
+  return static_cast<double>(position) * log2(static_cast<double>(position) + 2);
+}
+
+/**
+ * Extracts hexadecimal digits of Pi at a position without computing the ones before it
+ * (the Bailey-Borwein-Plouffe digit extraction algorithm)
+ * @param position The position of the first digit (1 is the first digit after the point)
+ * @param out Receives BBP_DIGITS uppercase hex digits
+ */
+void bbp_hex_digits(uint64_t position, char *out)
+{
+  uint64_t d = position - 1;
+  double x = 4 * bbp_series(d, 1) - 2 * bbp_series(d, 4) - bbp_series(d, 5) - bbp_series(d, 6);
+  x -= floor(x);
+
+  static const char hex[] = "0123456789ABCDEF";
+  for (int i = 0; i < BBP_DIGITS; ++i)
+  {
+    x *= 16;
+    int digit = static_cast<int>(x);
+    out[i] = hex[digit];
+    x -= digit;
+  }
+}
+
+// EOF
@@ -0,0 +1,36 @@
+// bbp_digits.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Bailey-Borwein-Plouffe digit extraction: hexadecimal digits of Pi at any position,
+// computed in double precision without the digits before them. Used to spot check long
+// results and digit files far beyond any reference that could be computed for them
+
+#ifndef BBP_DIGITS_HPP
+#define BBP_DIGITS_HPP
+
+#include <cstdint>
+
+#define BBP_DIGITS 6  // Hex digits extracted per position (the double sums are good for about 8)
+#define BBP_MAX_POSITION 10000000  // Beyond this the rounding error of the double sums can reach the extracted digits
+
+double bbp_steps(uint64_t position);
+void bbp_hex_digits(uint64_t position, char *out);
+
+#endif
+
+// EOF
@@ -0,0 +1,147 @@
+// benchmark.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "benchmark.hpp"
+#include "binary_splitting.hpp"
+#include "kernels.hpp"
+#include "output_writer.hpp"
+#include "parallel_arithmetic.hpp"
+#include "utility.hpp"
+#include <gmpxx.h>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define BENCHMARK_VERSION 1  // Bump whenever the workload changes, so old scores aren't compared with new ones
+#define BENCHMARK_THREADS 1  // Threads of the parallel multiply during the run, fixed so scores stay comparable
+#define EXTRA_DIGITS 16  // Digits converted past the workload so truncation never sees rounding
+
+// One benchmark workload and the hash of its correct output
+struct BenchmarkSize{
+  const char *label;
+  int digits;
+  uint64_t expected_hash;  // FNV-1a of the decimal places (without "3."), checked against an independent AGM run
+};
+
+// Fixed workloads: the Wii only has enough memory (and patience) for the smaller ones
+#ifdef GEKKO
+static const char *benchmark_platform = "wii";
+static const BenchmarkSize benchmark_sizes[] = {
+  {"10K", 10000, 0xEC7B9CA0DD41A929ULL},
+  {"100K", 100000, 0x787173EF15C2F208ULL}
+};
+#else
+static const char *benchmark_platform = "host";
+static const BenchmarkSize benchmark_sizes[] = {
+  {"1M", 1000000, 0xCE04279C6807286BULL},
+  {"8M", 8000000, 0x4D162DD1EA0BCACDULL},
+  {"32M", 32000000, 0x9D47BD1D6A147AA8ULL}
+};
+#endif
+
+/**
+ * Runs the fixed benchmark and prints a single copy-pasteable result line
+ * Every workload uses the Chudnovsky binary splitting engine as one full tree, with the
+ * parallel multiply pinned to BENCHMARK_THREADS whatever --threads asked for. Only the
+ * calculation is timed; the decimal conversion afterwards feeds the validation hash, so
+ * a run that produces wrong digits is reported as invalid instead of getting a score
+ */
+void run_benchmark()
+{
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Benchmark v" << BENCHMARK_VERSION << ": Chudnovsky Algorithm (Binary Splitting), "
+       << BENCHMARK_THREADS << " thread(s)" << endl;
+
+  // The workload must not depend on what was picked in the menus
+  size_t previous_limit = get_binary_splitting_memory_limit();
+  mp_bitcnt_t previous_precision = mpf_get_default_prec();
+  int previous_threads = get_parallel_threads();
+  set_binary_splitting_memory_limit(0);
+  set_parallel_threads(BENCHMARK_THREADS);
+
+  int num_sizes = sizeof(benchmark_sizes) / sizeof(benchmark_sizes[0]);
+  double total_seconds = 0;
+  double total_digits = 0;
+  bool all_valid = true;
+  string line = "WPCPP-BENCH v" + to_string(BENCHMARK_VERSION) + " " + benchmark_platform +
+                " engine=chudnovsky-bs threads=" + to_string(BENCHMARK_THREADS) +
+                " kernels=" + kernel_level_name(kernels.level);
+
+  for (int i = 0; i < num_sizes; ++i)
+  {
+    const BenchmarkSize &size = benchmark_sizes[i];
+    cout << "Running " << size.label << "... " << flush;
+
+    struct timeval start_time, end_time;
+    mpf_set_default_prec(static_cast<mp_bitcnt_t>(size.digits * 3.32193) + 64);
+    gettimeofday(&start_time, nullptr);
+    mpf_class pi = calculate_pi_chudnovsky_binary_splitting(size.digits);
+    gettimeofday(&end_time, nullptr);
+    double seconds = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+
+    // Convert a few digits more than needed and truncate, so the hash covers exact places
+    mp_exp_t exponent;
+    string digits = pi.get_str(exponent, 10, size.digits + EXTRA_DIGITS);
+    uint64_t hash = (exponent == 1 && digits.size() > static_cast<size_t>(size.digits)) ?
+                    hash_digits(digits.c_str() + 1, size.digits) : 0;
+    bool valid = (hash == size.expected_hash);
+
+    char result[96];
+    snprintf(result, sizeof(result), " %s=%.3fs/%016" PRIx64 "%s", size.label, seconds, hash, valid ? "" : "!");
+    line += result;
+    cout << seconds << " s, hash " << (valid ? "valid" : "INVALID") << endl;
+
+    all_valid = all_valid && valid;
+    total_seconds += seconds;
+    total_digits += size.digits;
+  }
+
+  set_binary_splitting_memory_limit(previous_limit);
+  mpf_set_default_prec(previous_precision);
+  set_parallel_threads(previous_threads);
+
+  // Score: digits per second over the whole workload (higher is better), withheld on a wrong answer
+  char score[64];
+  if (all_valid)
+  {
+    snprintf(score, sizeof(score), " total=%.3fs score=%.0f", total_seconds, total_digits / total_seconds);
+  }
+  else
+  {
+    snprintf(score, sizeof(score), " total=%.3fs score=INVALID", total_seconds);
+  }
+  line += score;
+
+  cout << "\n" << line << endl;
+
+  // Keep a record of the run next to the other logs
+  string path = string(output_storage_root()) + "/wpcpp_bench.log";
+  OutputWriter *writer = output_writer_open(path.c_str(), true, line.size() + 1);
+  if (writer)
+  {
+    line += "\n";
+    output_writer_write(writer, line.data(), line.size());
+    output_writer_close(writer, nullptr);
+  }
+}
+
+// EOF
@@ -0,0 +1,405 @@
+// binary_splitting.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "binary_splitting.hpp"
+#include "pi_calculation.hpp"
+#include "census.hpp"
+#include "parallel_arithmetic.hpp"
+#include <gmpxx.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define GUARD_BITS 64  // Extra fixed-point bits that absorb truncation error from each block
+#define CANCEL_CHECK_TERMS 64  // Subtrees at least this large check for cancellation and report progress
+
+// Upper bound on the memory a segmented calculation may use (0 means unlimited, i.e. one block)
+static size_t memory_limit = 0;
+
+/**
+ * Sets the memory cap for the segmented binary splitting mode
+ * @param bytes The maximum number of bytes the calculation may use, or 0 for no limit
+ */
+void set_binary_splitting_memory_limit(size_t bytes)
+{
+  memory_limit = bytes;
+}
+
+/**
+ * Returns the memory cap for the segmented binary splitting mode
+ * @return The maximum number of bytes the calculation may use, or 0 for no limit
+ */
+size_t get_binary_splitting_memory_limit()
+{
+  return memory_limit;
+}
+
+/**
+ * Frees the limbs of an integer that is no longer needed (assigning 0 keeps them allocated)
+ * @param value The integer to release
+ */
+static void release(mpz_class &value)
+{
+  mpz_class empty;
+  value.swap(empty);
+}
+
+/**
+ * Computes P, Q and T of the Chudnovsky series over the terms [a, b) by binary splitting
+ * Leaves are P(k) = (6k-5)(2k-1)(6k-1), Q(k) = k^3 * 640320^3 / 24 and
+ * T(k) = (-1)^k * P(k) * (13591409 + 545140134k), with P(0) = Q(0) = 1
+ * @param a First term of the range
+ * @param b One past the last term of the range
+ * @param P Receives the product of the P(k)
+ * @param Q Receives the product of the Q(k)
+ * @param T Receives the combined numerator of the range
+ * @param total_terms Number of terms in the whole series, used for progress reports
+ */
+static void chudnovsky_split(unsigned long a, unsigned long b, mpz_class &P, mpz_class &Q, mpz_class &T,
+                             unsigned long total_terms)
+{
+  if (b - a == 1)
+  {
+    if (a == 0)
+    {
+      P = 1;
+      Q = 1;
+    }
+    else
+    {
+      // 640320^3 / 24 does not fit in a 32-bit unsigned long, so it is kept as an mpz
+      static const mpz_class c3_over_24 = mpz_class("10939058860032000");
+
+      P = 6 * a - 5;
+      census_mpz_mul_ui(P.get_mpz_t(), P.get_mpz_t(), 2 * a - 1);
+      census_mpz_mul_ui(P.get_mpz_t(), P.get_mpz_t(), 6 * a - 1);
+
+      Q = c3_over_24;
+      census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+      census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+      census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+    }
+
+    // T(k) = P(k) * (13591409 + 545140134k), built in an mpz since the factor overflows 32 bits
+    T = 545140134;
+    census_mpz_mul_ui(T.get_mpz_t(), T.get_mpz_t(), a);
+    census_mpz_add_ui(T.get_mpz_t(), T.get_mpz_t(), 13591409);
+    census_mpz_mul(T.get_mpz_t(), T.get_mpz_t(), P.get_mpz_t());
+
+    if (a & 1)
+    {
+      mpz_neg(T.get_mpz_t(), T.get_mpz_t());  // Odd terms are subtracted
+    }
+    return;
+  }
+
+  // Large subtrees give up early once cancelled; the caller discards the partial result
+  if (b - a >= CANCEL_CHECK_TERMS && calculation_cancelled())
+  {
+    return;
+  }
+
+  unsigned long m = (a + b) / 2;
+  mpz_class P2, Q2, T2;  // Right half of the range
+
+  chudnovsky_split(a, m, P, Q, T, total_terms);
+  chudnovsky_split(m, b, P2, Q2, T2, total_terms);
+
+  // Merge: T = T1 * Q2 + P1 * T2, P = P1 * P2, Q = Q1 * Q2
+  parallel_mpz_mul(T.get_mpz_t(), T.get_mpz_t(), Q2.get_mpz_t());
+  parallel_mpz_mul(T2.get_mpz_t(), T2.get_mpz_t(), P.get_mpz_t());
+  census_mpz_add(T.get_mpz_t(), T.get_mpz_t(), T2.get_mpz_t());
+  parallel_mpz_mul(P.get_mpz_t(), P.get_mpz_t(), P2.get_mpz_t());
+  parallel_mpz_mul(Q.get_mpz_t(), Q.get_mpz_t(), Q2.get_mpz_t());
+
+  if (b - a >= CANCEL_CHECK_TERMS)
+  {
+    report_calculation_progress(static_cast<double>(b) / total_terms);
+  }
+}
+
+/**
+ * Estimates the peak number of bytes the calculation keeps alive while a block over [a, b)
+ * is evaluated. Each term adds roughly 3 * log2(k) + 60 bits to each of P, Q and T.
+ * The peak comes from accumulating the block rather than from building its tree: P, Q
+ * and T stay alive next to the fixed-point sum and scale while scale * T is formed and
+ * divided by Q, and GMP's division takes about 4 times the sum size plus 11 times the
+ * block size in products and scratch (measured), so the total is 6 sums plus 14 blocks
+ * @param a First term of the block
+ * @param b One past the last term of the block
+ * @param bits The number of fixed-point bits of the sum
+ * @return The estimated peak memory in bytes
+ */
+static size_t estimate_block_bytes(unsigned long a, unsigned long b, mp_bitcnt_t bits)
+{
+  double bits_per_term = 3.0 * log2(static_cast<double>(b) + 1.0) + 60.0;
+  double block_bytes = (b - a) * bits_per_term / 8.0;  // Size of each of P, Q and T
+  return static_cast<size_t>(bits / 8.0 * 6.0 + block_bytes * 14.0);
+}
+
+/**
+ * Estimates the peak number of bytes of the final steps, once everything but the sum is
+ * released: the 3 * bits numerator and about 13 times the sum size in division scratch
+ * @param bits The number of fixed-point bits of the sum
+ * @return The estimated peak memory in bytes
+ */
+static size_t estimate_final_bytes(mp_bitcnt_t bits)
+{
+  return static_cast<size_t>(bits / 8.0 * 17.0);
+}
+
+/**
+ * Estimates the peak memory of a full (unsegmented) binary splitting run, including the
+ * fixed-point sum and the final steps
+ * @param precision The number of decimal places of Pi
+ * @return The estimated peak memory in bytes
+ */
+size_t estimate_binary_splitting_bytes(int precision)
+{
+  unsigned long terms = static_cast<unsigned long>(precision / CHUDNOVSKY_DIGITS_PER_TERM) + 2;
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(precision * 3.32193) + GUARD_BITS;
+  return max(estimate_block_bytes(0, terms, bits), estimate_final_bytes(bits));
+}
+
+/**
+ * Estimates the smallest memory limit a segmented run can keep to: blocks of a single
+ * term, next to the fixed-point state that every run needs regardless of the block size
+ * @param precision The number of decimal places of Pi
+ * @return The estimated minimum memory in bytes
+ */
+size_t estimate_binary_splitting_minimum_bytes(int precision)
+{
+  unsigned long terms = static_cast<unsigned long>(precision / CHUDNOVSKY_DIGITS_PER_TERM) + 2;
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(precision * 3.32193) + GUARD_BITS;
+  return max(estimate_block_bytes(terms - 1, terms, bits), estimate_final_bytes(bits));
+}
+
+/**
+ * Calculates Pi using the Chudnovsky algorithm evaluated by binary splitting
+ * With a memory limit set, the series is split into consecutive blocks of terms: each
+ * block tree is reduced to a fixed-point contribution that is accumulated, so only one
+ * block tree is alive at a time. This caps peak memory at the cost of some speed.
+ * Without a limit the whole series is a single block (a full binary splitting tree).
+ * A limit below estimate_binary_splitting_minimum_bytes() cannot hold the fixed-point
+ * state itself, so the calculation is refused
+ * If the caller asks for the certified digit count, a cancellation after at least one
+ * completed block still produces a result from the blocks done so far: k terms of the
+ * series are accurate to about 14.18 * k digits, and the final steps then run at that
+ * reduced precision only
+ * @param precision The number of decimal places of Pi to calculate
+ * @param certified_digits If not nullptr, receives the number of correct decimal places
+ *                         and enables partial results on cancellation
+ * @return The calculated value of Pi, or 0 if the calculation was refused or cancelled without a usable result
+ */
+mpf_class calculate_pi_chudnovsky_binary_splitting(int precision, int *certified_digits)
+{
+  unsigned long terms = static_cast<unsigned long>(precision / CHUDNOVSKY_DIGITS_PER_TERM) + 2;
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(precision * 3.32193) + GUARD_BITS;
+
+  // The fixed-point state alone can exceed a small limit; refuse rather than overrun it
+  if (memory_limit != 0 && memory_limit < estimate_binary_splitting_minimum_bytes(precision))
+  {
+    return mpf_class(0);
+  }
+
+  mpz_class sum = 0;  // Fixed-point sum of the series, scaled by 2^bits
+  mpz_class scale = 1;  // Fixed-point P(0, k0) / Q(0, k0), the prefix product in front of each block
+  mpz_mul_2exp(scale.get_mpz_t(), scale.get_mpz_t(), bits);
+
+  mpz_class P, Q, T, contribution;
+  unsigned long block_start = 0;
+
+  while (block_start < terms)
+  {
+    // Grow the block until the estimated peak would exceed the memory limit (always at least one term)
+    unsigned long block_end = terms;
+    if (memory_limit != 0)
+    {
+      block_end = block_start + 1;
+      while (block_end < terms && estimate_block_bytes(block_start, block_end * 2 - block_start, bits) <= memory_limit)
+      {
+        block_end = block_end * 2 - block_start;
+      }
+      block_end = min(block_end, terms);
+    }
+
+    census_begin_phase("series");
+    chudnovsky_split(block_start, block_end, P, Q, T, terms);
+    if (calculation_cancelled())
+    {
+      if (!certified_digits || block_start == 0)
+      {
+        return mpf_class(0);
+      }
+      break;  // Finish with the blocks completed so far
+    }
+
+    // sum += scale * T / Q
+    census_begin_phase("accumulate");
+    parallel_mpz_mul(contribution.get_mpz_t(), scale.get_mpz_t(), T.get_mpz_t());
+    parallel_mpz_tdiv_q(contribution.get_mpz_t(), contribution.get_mpz_t(), Q.get_mpz_t());
+    census_mpz_add(sum.get_mpz_t(), sum.get_mpz_t(), contribution.get_mpz_t());
+
+    // scale *= P / Q for the next block (not needed after the last one)
+    if (block_end < terms)
+    {
+      parallel_mpz_mul(scale.get_mpz_t(), scale.get_mpz_t(), P.get_mpz_t());
+      parallel_mpz_tdiv_q(scale.get_mpz_t(), scale.get_mpz_t(), Q.get_mpz_t());
+    }
+
+    block_start = block_end;
+  }
+
+  // Blocks below CANCEL_CHECK_TERMS do not report, so mark the end of the series here
+  report_calculation_progress(static_cast<double>(block_start) / terms);
+
+  // Release the last block tree and the accumulation state before the final steps
+  release(P);
+  release(Q);
+  release(T);
+  release(scale);
+  release(contribution);
+
+  // A partial series certifies fewer digits, so drop the bits it cannot support
+  int digits = precision;
+  if (block_start < terms)
+  {
+    digits = min(precision, static_cast<int>(block_start * CHUDNOVSKY_DIGITS_PER_TERM) - 2);
+    mp_bitcnt_t reduced_bits = static_cast<mp_bitcnt_t>(digits * 3.32193) + GUARD_BITS;
+    mpz_fdiv_q_2exp(sum.get_mpz_t(), sum.get_mpz_t(), bits - reduced_bits);
+    bits = reduced_bits;
+  }
+  if (certified_digits)
+  {
+    *certified_digits = digits;
+  }
+
+  // Pi = 426880 * sqrt(10005) / sum, with sqrt(10005) formed as an integer square root in fixed point
+  census_begin_phase("final");
+  mpz_class pi_fixed = 10005;
+  mpz_mul_2exp(pi_fixed.get_mpz_t(), pi_fixed.get_mpz_t(), 2 * bits);
+  census_mpz_sqrt(pi_fixed.get_mpz_t(), pi_fixed.get_mpz_t());
+  census_mpz_mul_ui(pi_fixed.get_mpz_t(), pi_fixed.get_mpz_t(), 426880);
+  mpz_mul_2exp(pi_fixed.get_mpz_t(), pi_fixed.get_mpz_t(), bits);
+  parallel_mpz_tdiv_q(pi_fixed.get_mpz_t(), pi_fixed.get_mpz_t(), sum.get_mpz_t());
+
+  // Convert the fixed-point integer back to a floating-point value
+  mpf_class pi;
+  mpf_set_z(pi.get_mpf_t(), pi_fixed.get_mpz_t());
+  mpf_div_2exp(pi.get_mpf_t(), pi.get_mpf_t(), bits);
+  return pi;
+}
+
+/**
+ * Computes Q and T of the BBP series over the terms [a, b) by binary splitting
+ * Each term 16^-k * (4/(8k+1) - 2/(8k+4) - 1/(8k+5) - 1/(8k+6)) is combined into one
+ * fraction p(k) / q(k) with p(k) = 120k^2 + 151k + 47 and
+ * q(k) = 512k^4 + 1024k^3 + 712k^2 + 194k + 15, so that the range sums to
+ * sum_{k=a}^{b-1} 16^-(k-a) * p(k) / q(k) = T / (Q * 16^(b-a-1))
+ * @param a First term of the range
+ * @param b One past the last term of the range
+ * @param Q Receives the product of the q(k)
+ * @param T Receives the combined numerator of the range
+ * @param total_terms Number of terms in the whole series, used for progress reports
+ */
+static void bbp_split(unsigned long a, unsigned long b, mpz_class &Q, mpz_class &T, unsigned long total_terms)
+{
+  if (b - a == 1)
+  {
+    // Horner's rule on mpz values, since both polynomials overflow 32 bits for large k
+    T = 120;
+    census_mpz_mul_ui(T.get_mpz_t(), T.get_mpz_t(), a);
+    census_mpz_add_ui(T.get_mpz_t(), T.get_mpz_t(), 151);
+    census_mpz_mul_ui(T.get_mpz_t(), T.get_mpz_t(), a);
+    census_mpz_add_ui(T.get_mpz_t(), T.get_mpz_t(), 47);
+
+    Q = 512;
+    census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+    census_mpz_add_ui(Q.get_mpz_t(), Q.get_mpz_t(), 1024);
+    census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+    census_mpz_add_ui(Q.get_mpz_t(), Q.get_mpz_t(), 712);
+    census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+    census_mpz_add_ui(Q.get_mpz_t(), Q.get_mpz_t(), 194);
+    census_mpz_mul_ui(Q.get_mpz_t(), Q.get_mpz_t(), a);
+    census_mpz_add_ui(Q.get_mpz_t(), Q.get_mpz_t(), 15);
+    return;
+  }
+
+  // Large subtrees give up early once cancelled; the caller discards the partial result
+  if (b - a >= CANCEL_CHECK_TERMS && calculation_cancelled())
+  {
+    return;
+  }
+
+  unsigned long m = (a + b) / 2;
+  mpz_class Q2, T2;  // Right half of the range
+
+  bbp_split(a, m, Q, T, total_terms);
+  bbp_split(m, b, Q2, T2, total_terms);
+
+  // Merge: T = T1 * Q2 * 16^(b-m) + T2 * Q1, Q = Q1 * Q2 (the power of 16 is a shift)
+  parallel_mpz_mul(T.get_mpz_t(), T.get_mpz_t(), Q2.get_mpz_t());
+  mpz_mul_2exp(T.get_mpz_t(), T.get_mpz_t(), 4 * (b - m));
+  parallel_mpz_mul(T2.get_mpz_t(), T2.get_mpz_t(), Q.get_mpz_t());
+  census_mpz_add(T.get_mpz_t(), T.get_mpz_t(), T2.get_mpz_t());
+  parallel_mpz_mul(Q.get_mpz_t(), Q.get_mpz_t(), Q2.get_mpz_t());
+
+  if (b - a >= CANCEL_CHECK_TERMS)
+  {
+    report_calculation_progress(static_cast<double>(b) / total_terms);
+  }
+}
+
+/**
+ * Calculates Pi using the Bailey-Borwein-Plouffe (BBP) formula evaluated by binary splitting
+ * Each term adds 4 bits, so the term count follows from the precision, and the whole
+ * series is reduced to a single fraction T / (Q * 16^(n-1)) with one final division.
+ * This is O(M(n) log^2 n) like the Chudnovsky engine, though with a larger constant,
+ * since each term contributes far fewer bits relative to the size of q(k)
+ * @param precision The number of decimal places of Pi to calculate
+ * @return The calculated value of Pi, or 0 if the calculation was cancelled
+ */
+mpf_class calculate_pi_bbp_binary_splitting(int precision)
+{
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(precision * 3.32193) + GUARD_BITS;
+  unsigned long terms = bits / 4 + 1;  // The tail after n terms is below 16^-n
+
+  mpz_class Q, T;
+  census_begin_phase("series");
+  bbp_split(0, terms, Q, T, terms);
+  if (calculation_cancelled())
+  {
+    return mpf_class(0);
+  }
+  report_calculation_progress(1.0);  // A series below CANCEL_CHECK_TERMS does not report
+
+  // Pi * 2^bits = T * 2^(bits - 4(n-1)) / Q, where 4(n-1) <= bits by the choice of n
+  census_begin_phase("final");
+  mpz_mul_2exp(T.get_mpz_t(), T.get_mpz_t(), bits - 4 * (terms - 1));
+  parallel_mpz_tdiv_q(T.get_mpz_t(), T.get_mpz_t(), Q.get_mpz_t());
+  Q = 0;
+
+  // Convert the fixed-point integer back to a floating-point value
+  mpf_class pi;
+  mpf_set_z(pi.get_mpf_t(), T.get_mpz_t());
+  mpf_div_2exp(pi.get_mpf_t(), pi.get_mpf_t(), bits);
+  return pi;
+}
+
+// EOF
@@ -0,0 +1,36 @@
+// binary_splitting.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BINARY_SPLITTING_HPP
+#define BINARY_SPLITTING_HPP
+
+#include <gmpxx.h>
+#include <cstddef>
+
+#define CHUDNOVSKY_DIGITS_PER_TERM 14.1816474627  // log10(640320^3 / 1728), digits gained per term
+
+void set_binary_splitting_memory_limit(size_t bytes);
+size_t get_binary_splitting_memory_limit();
+size_t estimate_binary_splitting_bytes(int precision);
+size_t estimate_binary_splitting_minimum_bytes(int precision);
+mpf_class calculate_pi_chudnovsky_binary_splitting(int precision, int *certified_digits = nullptr);
+mpf_class calculate_pi_bbp_binary_splitting(int precision);
+
+#endif
+
+// EOF
@@ -0,0 +1,131 @@
+// census.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "census.hpp"
+
+#ifdef WPCPP_CENSUS
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+static const char *operation_names[CENSUS_OPERATION_COUNT] = {"mul", "div", "sqrt", "small", "add"};
+
+// Operation counts per phase, operation and operand size class
+static unsigned long counts[CENSUS_MAX_PHASES][CENSUS_OPERATION_COUNT][CENSUS_SIZE_CLASSES];
+static const char *phase_names[CENSUS_MAX_PHASES];
+static int num_phases = 0;
+static int current_phase = 0;
+
+/**
+ * Clears all counts and phases before a new calculation
+ */
+void census_reset()
+{
+  memset(counts, 0, sizeof(counts));
+  num_phases = 0;
+  current_phase = 0;
+}
+
+/**
+ * Attributes the following operations to a named phase
+ * Phases are matched by name, so re-entering a phase keeps adding to it; once all slots
+ * are used, further phases are merged into the last one
+ * @param name The phase name (must stay valid until the census is printed)
+ */
+void census_begin_phase(const char *name)
+{
+  for (int i = 0; i < num_phases; ++i)
+  {
+    if (strcmp(phase_names[i], name) == 0)
+    {
+      current_phase = i;
+      return;
+    }
+  }
+
+  if (num_phases < CENSUS_MAX_PHASES)
+  {
+    phase_names[num_phases] = name;
+    current_phase = num_phases++;
+  }
+}
+
+/**
+ * Counts one operation in the current phase
+ * @param operation The kind of operation
+ * @param limbs The size of the largest operand in limbs (words for the fixed-point engine)
+ */
+void census_record(CensusOperation operation, size_t limbs)
+{
+  if (num_phases == 0)
+  {
+    census_begin_phase("main");  // Operations outside any named phase
+  }
+
+  // Size class c covers 2^(c-1) < limbs <= 2^c
+  int size_class = 0;
+  while ((static_cast<size_t>(1) << size_class) < limbs && size_class < CENSUS_SIZE_CLASSES - 1)
+  {
+    ++size_class;
+  }
+
+  counts[current_phase][operation][size_class]++;
+}
+
+/**
+ * Prints the histogram of every phase: one line per operation, listing
+ * "<=limbs:count" for each non-empty size class
+ */
+void census_print()
+{
+  cout << "\nOperation census (size classes in limbs):" << endl;
+
+  for (int phase = 0; phase < num_phases; ++phase)
+  {
+    cout << "[" << phase_names[phase] << "]" << endl;
+
+    for (int operation = 0; operation < CENSUS_OPERATION_COUNT; ++operation)
+    {
+      unsigned long total = 0;
+      for (int c = 0; c < CENSUS_SIZE_CLASSES; ++c)
+      {
+        total += counts[phase][operation][c];
+      }
+      if (total == 0)
+      {
+        continue;
+      }
+
+      cout << "  " << operation_names[operation] << " (" << total << "):";
+      for (int c = 0; c < CENSUS_SIZE_CLASSES; ++c)
+      {
+        if (counts[phase][operation][c] != 0)
+        {
+          cout << " <=" << (1ul << c) << ":" << counts[phase][operation][c];
+        }
+      }
+      cout << endl;
+    }
+  }
+}
+
+#endif
+
+// EOF
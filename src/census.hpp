@@ -0,0 +1,152 @@
+// census.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Arithmetic operation census: counts the big-number operations an engine performs,
+// bucketed by operand size and grouped by phase. Enabled by building with CENSUS=1
+// (which defines WPCPP_CENSUS); otherwise the wrappers below compile to the plain GMP calls
+
+#ifndef CENSUS_HPP
+#define CENSUS_HPP
+
+#include <gmp.h>
+#include <cstddef>
+
+#define CENSUS_MAX_PHASES 8  // Distinct phases tracked per calculation
+#define CENSUS_SIZE_CLASSES 24  // Size class c holds operands of up to 2^c limbs
+
+enum CensusOperation{
+  CENSUS_MUL,  // Full multiplication (or squaring)
+  CENSUS_DIV,  // Full division
+  CENSUS_SQRT,  // Square root
+  CENSUS_SMALL,  // Operation with a single-word operand (mul_ui, div_ui, add_ui, ...)
+  CENSUS_ADD,  // Full addition or subtraction
+  CENSUS_OPERATION_COUNT
+};
+
+#ifdef WPCPP_CENSUS
+
+void census_reset();
+void census_begin_phase(const char *name);
+void census_record(CensusOperation operation, size_t limbs);
+void census_print();
+
+#else
+
+inline void census_reset() {}
+inline void census_begin_phase(const char *) {}
+inline void census_record(CensusOperation, size_t) {}
+inline void census_print() {}
+
+#endif
+
+/**
+ * Returns the limb count of the larger of two integers, used as the operation's size
+ * @param a The first operand
+ * @param b The second operand
+ * @return The larger limb count
+ */
+inline size_t census_limbs(mpz_srcptr a, mpz_srcptr b)
+{
+  size_t size_a = mpz_size(a);
+  size_t size_b = mpz_size(b);
+  return size_a > size_b ? size_a : size_b;
+}
+
+// Counting wrappers for the GMP calls used by the engines
+
+inline void census_mpz_mul(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_MUL, census_limbs(a, b));
+  mpz_mul(result, a, b);
+}
+
+inline void census_mpz_tdiv_q(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_DIV, census_limbs(a, b));
+  mpz_tdiv_q(result, a, b);
+}
+
+inline void census_mpz_sqrt(mpz_ptr result, mpz_srcptr a)
+{
+  census_record(CENSUS_SQRT, mpz_size(a));
+  mpz_sqrt(result, a);
+}
+
+inline void census_mpz_add(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_ADD, census_limbs(a, b));
+  mpz_add(result, a, b);
+}
+
+inline void census_mpz_sub(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_ADD, census_limbs(a, b));
+  mpz_sub(result, a, b);
+}
+
+inline void census_mpz_mul_ui(mpz_ptr result, mpz_srcptr a, unsigned long b)
+{
+  census_record(CENSUS_SMALL, mpz_size(a));
+  mpz_mul_ui(result, a, b);
+}
+
+inline void census_mpz_add_ui(mpz_ptr result, mpz_srcptr a, unsigned long b)
+{
+  census_record(CENSUS_SMALL, mpz_size(a));
+  mpz_add_ui(result, a, b);
+}
+
+inline void census_mpz_addmul_ui(mpz_ptr result, mpz_srcptr a, unsigned long b)
+{
+  census_record(CENSUS_SMALL, mpz_size(a));
+  mpz_addmul_ui(result, a, b);
+}
+
+inline void census_mpf_mul(mpf_ptr result, mpf_srcptr a, mpf_srcptr b)
+{
+  census_record(CENSUS_MUL, mpf_get_prec(result) / GMP_NUMB_BITS + 1);
+  mpf_mul(result, a, b);
+}
+
+inline void census_mpf_div(mpf_ptr result, mpf_srcptr a, mpf_srcptr b)
+{
+  census_record(CENSUS_DIV, mpf_get_prec(result) / GMP_NUMB_BITS + 1);
+  mpf_div(result, a, b);
+}
+
+inline void census_mpf_ui_div(mpf_ptr result, unsigned long a, mpf_srcptr b)
+{
+  census_record(CENSUS_DIV, mpf_get_prec(result) / GMP_NUMB_BITS + 1);
+  mpf_ui_div(result, a, b);
+}
+
+inline void census_mpf_sqrt_ui(mpf_ptr result, unsigned long a)
+{
+  census_record(CENSUS_SQRT, mpf_get_prec(result) / GMP_NUMB_BITS + 1);
+  mpf_sqrt_ui(result, a);
+}
+
+inline void census_mpf_mul_ui(mpf_ptr result, mpf_srcptr a, unsigned long b)
+{
+  census_record(CENSUS_SMALL, mpf_get_prec(result) / GMP_NUMB_BITS + 1);
+  mpf_mul_ui(result, a, b);
+}
+
+#endif
+
+// EOF
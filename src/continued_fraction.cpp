@@ -0,0 +1,409 @@
+// continued_fraction.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "continued_fraction.hpp"
+#include "binary_splitting.hpp"
+#include "census.hpp"
+#include "output_writer.hpp"
+#include <gmpxx.h>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define SHOWN_TERMS 20  // Terms shown on screen (all of them are saved)
+#define SHOWN_CONVERGENTS 8  // Convergents shown on screen
+
+// The map x = (m00 * t + m01) / (m10 * t + m11) from the tail t left after some terms
+// to the value they were taken from; its columns are the last two convergents
+struct CfMatrix{
+  mpz_class m00, m01;
+  mpz_class m10, m11;
+};
+
+/**
+ * Resets a matrix to the identity (no terms taken)
+ * @param m The matrix to reset
+ */
+static void matrix_identity(CfMatrix &m)
+{
+  m.m00 = 1;
+  m.m01 = 0;
+  m.m10 = 0;
+  m.m11 = 1;
+}
+
+/**
+ * Appends one term to a matrix: M = M * [[q, 1], [1, 0]]
+ * @param m The matrix to extend
+ * @param q The term
+ */
+static void matrix_push_term(CfMatrix &m, unsigned long q)
+{
+  mpz_swap(m.m00.get_mpz_t(), m.m01.get_mpz_t());
+  census_mpz_addmul_ui(m.m00.get_mpz_t(), m.m01.get_mpz_t(), q);
+  mpz_swap(m.m10.get_mpz_t(), m.m11.get_mpz_t());
+  census_mpz_addmul_ui(m.m10.get_mpz_t(), m.m11.get_mpz_t(), q);
+}
+
+/**
+ * Appends the terms of another matrix to a matrix: M = M * S
+ * @param m The matrix to extend
+ * @param s The matrix of the following terms
+ */
+static void matrix_multiply(CfMatrix &m, const CfMatrix &s)
+{
+  mpz_class t0, t1;
+
+  for (int row = 0; row < 2; ++row)
+  {
+    mpz_class &x0 = row ? m.m10 : m.m00;
+    mpz_class &x1 = row ? m.m11 : m.m01;
+
+    census_mpz_mul(t0.get_mpz_t(), x0.get_mpz_t(), s.m00.get_mpz_t());
+    census_mpz_mul(t1.get_mpz_t(), x1.get_mpz_t(), s.m10.get_mpz_t());
+    census_mpz_add(t0.get_mpz_t(), t0.get_mpz_t(), t1.get_mpz_t());
+    census_mpz_mul(x0.get_mpz_t(), x0.get_mpz_t(), s.m01.get_mpz_t());
+    census_mpz_mul(x1.get_mpz_t(), x1.get_mpz_t(), s.m11.get_mpz_t());
+    census_mpz_add(x1.get_mpz_t(), x1.get_mpz_t(), x0.get_mpz_t());
+    mpz_swap(x0.get_mpz_t(), t0.get_mpz_t());
+  }
+}
+
+/**
+ * Replaces a rational a / b by its tail after a matrix's terms: t = (m11 a - m01 b) / (m00 b - m10 a)
+ * @param m The matrix of terms already taken from a / b
+ * @param a The numerator, replaced by the tail's numerator
+ * @param b The denominator, replaced by the tail's (positive) denominator
+ */
+static void apply_inverse(const CfMatrix &m, mpz_class &a, mpz_class &b)
+{
+  mpz_class numerator, denominator, product;
+
+  census_mpz_mul(numerator.get_mpz_t(), m.m11.get_mpz_t(), a.get_mpz_t());
+  census_mpz_mul(product.get_mpz_t(), m.m01.get_mpz_t(), b.get_mpz_t());
+  numerator -= product;
+  census_mpz_mul(denominator.get_mpz_t(), m.m00.get_mpz_t(), b.get_mpz_t());
+  census_mpz_mul(product.get_mpz_t(), m.m10.get_mpz_t(), a.get_mpz_t());
+  denominator -= product;
+
+  // The determinant is +-1, so both signs flip together when it is negative
+  if (sgn(denominator) < 0)
+  {
+    numerator = -numerator;
+    denominator = -denominator;
+  }
+
+  mpz_swap(a.get_mpz_t(), numerator.get_mpz_t());
+  mpz_swap(b.get_mpz_t(), denominator.get_mpz_t());
+}
+
+/**
+ * Takes the next term from both rationals a / b and c / d if they agree on it
+ * A term is only taken when neither remainder is zero: a rational that ends exactly on the
+ * term could also be written with the term minus one, so the term is not certain
+ * @param a The first numerator, replaced by its tail's numerator
+ * @param b The first denominator, replaced by its tail's denominator
+ * @param c The second numerator, replaced by its tail's numerator
+ * @param d The second denominator, replaced by its tail's denominator
+ * @param term Receives the common term
+ * @return True if a common term was taken
+ */
+static bool euclid_step(mpz_class &a, mpz_class &b, mpz_class &c, mpz_class &d, unsigned long &term)
+{
+  if (sgn(b) == 0 || sgn(d) == 0)
+  {
+    return false;
+  }
+
+  mpz_class q1, r1, q2, r2;
+  mpz_fdiv_qr(q1.get_mpz_t(), r1.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+  mpz_fdiv_qr(q2.get_mpz_t(), r2.get_mpz_t(), c.get_mpz_t(), d.get_mpz_t());
+
+  // Terms too large for a word are not expected in practice, so they end the expansion
+  if (q1 != q2 || sgn(r1) == 0 || sgn(r2) == 0 || !q1.fits_ulong_p())
+  {
+    return false;
+  }
+
+  term = q1.get_ui();
+  mpz_swap(a.get_mpz_t(), b.get_mpz_t());
+  mpz_swap(b.get_mpz_t(), r1.get_mpz_t());
+  mpz_swap(c.get_mpz_t(), d.get_mpz_t());
+  mpz_swap(d.get_mpz_t(), r2.get_mpz_t());
+  return true;
+}
+
+/**
+ * Finds the terms two positive rationals a / b and c / d have in common, and so the terms
+ * of every number between them (half-GCD style)
+ * The top half of each operand brackets its rational in a wider interval of half-size
+ * numbers; the terms common to that interval are found recursively, which also certifies
+ * them for the full-size rationals. Their matrix then reduces the full operands to tails of
+ * about half the size in a few multiplications, and the loop continues on the tails. Each
+ * size is handled by a half-size subproblem plus a constant number of full-size products,
+ * O(M(n) log n) overall instead of the O(n^2) of term-by-term Euclid
+ * @param a The first numerator
+ * @param b The first denominator
+ * @param c The second numerator
+ * @param d The second denominator
+ * @param terms Receives the common terms, appended in order
+ * @param m Receives the matrix of the terms this call appended
+ */
+static void common_prefix(mpz_class a, mpz_class b, mpz_class c, mpz_class d, vector<unsigned long> &terms, CfMatrix &m)
+{
+  matrix_identity(m);
+  unsigned long term;
+
+  while (true)
+  {
+    size_t bits = max(max(mpz_sizeinbase(a.get_mpz_t(), 2), mpz_sizeinbase(b.get_mpz_t(), 2)),
+                      max(mpz_sizeinbase(c.get_mpz_t(), 2), mpz_sizeinbase(d.get_mpz_t(), 2)));
+
+    if (bits <= CF_BASE_BITS)
+    {
+      while (euclid_step(a, b, c, d, term))
+      {
+        terms.push_back(term);
+        matrix_push_term(m, term);
+      }
+      return;
+    }
+
+    mp_bitcnt_t shift = bits / 2;
+    mpz_class a_top = a >> shift, b_top = b >> shift;
+    mpz_class c_top = c >> shift, d_top = d >> shift;
+
+    if (sgn(b_top) > 0 && sgn(d_top) > 0)
+    {
+      // a / b lies in [a_top / (b_top + 1), (a_top + 1) / b_top], and likewise c / d;
+      // the interval spanning both brackets is expanded instead
+      mpz_class lower_num = a_top, lower_den = b_top + 1;
+      mpz_class upper_num = a_top + 1, upper_den = b_top;
+
+      if (c_top * lower_den < lower_num * (d_top + 1))
+      {
+        lower_num = c_top;
+        lower_den = d_top + 1;
+      }
+      if ((c_top + 1) * upper_den > upper_num * d_top)
+      {
+        upper_num = c_top + 1;
+        upper_den = d_top;
+      }
+
+      size_t found = terms.size();
+      CfMatrix top;
+      common_prefix(lower_num, lower_den, upper_num, upper_den, terms, top);
+
+      if (terms.size() > found)
+      {
+        apply_inverse(top, a, b);
+        apply_inverse(top, c, d);
+        matrix_multiply(m, top);
+        continue;
+      }
+    }
+
+    // The top halves settled nothing (a very large term), so take one step at full size
+    if (!euclid_step(a, b, c, d, term))
+    {
+      return;
+    }
+    terms.push_back(term);
+    matrix_push_term(m, term);
+  }
+}
+
+/**
+ * Finds the continued fraction terms two positive rationals a / b and c / d have in common
+ * Every number between the two shares these terms, so bracketing a value between them
+ * certifies its leading terms
+ * @param a The first numerator
+ * @param b The first denominator
+ * @param c The second numerator
+ * @param d The second denominator
+ * @param terms Receives the common terms
+ * @param p Receives the numerator of the last convergent
+ * @param q Receives the denominator of the last convergent
+ */
+void continued_fraction_common_prefix(mpz_class a, mpz_class b, mpz_class c, mpz_class d,
+                                      vector<unsigned long> &terms, mpz_class &p, mpz_class &q)
+{
+  CfMatrix m;
+  terms.clear();
+  common_prefix(a, b, c, d, terms, m);
+  p = m.m00;
+  q = m.m10;
+}
+
+/**
+ * Returns the seconds elapsed since a start time
+ * @param start The start time
+ * @return The elapsed time in seconds
+ */
+static double elapsed_seconds(const struct timeval &start)
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1000000.0;
+}
+
+/**
+ * Returns the natural logarithm of a positive integer of any size
+ * @param x The integer
+ * @return ln(x)
+ */
+static double log_mpz(const mpz_class &x)
+{
+  signed long exponent;
+  double mantissa = mpz_get_d_2exp(&exponent, x.get_mpz_t());
+  return log(mantissa) + exponent * log(2.0);
+}
+
+/**
+ * Saves all the terms to the SD card through the background writer, one per line
+ * @param terms The terms to save
+ */
+static void save_terms(const vector<unsigned long> &terms)
+{
+  string path = string(output_storage_root()) + "/pi_cf.txt";
+  OutputWriter *writer = output_writer_open(path.c_str(), false);
+  if (!writer)
+  {
+    return;
+  }
+
+  char line[24];
+  for (size_t i = 0; i < terms.size(); ++i)
+  {
+    int length = snprintf(line, sizeof(line), "%lu\n", terms[i]);
+    output_writer_write(writer, line, length);
+  }
+
+  OutputWriterStats stats;
+  if (output_writer_close(writer, &stats))
+  {
+    cout << "Saved " << terms.size() << " term(s) to " << path << " (" << stats.megabytes_per_second << " MB/s)" << endl;
+  }
+}
+
+/**
+ * Calculates Pi and expands it into its continued fraction
+ * Pi is calculated by binary splitting and truncated to P / 2^bits. The calculated value
+ * may be off by a little in either direction, so Pi is bracketed by [(P - 1) / 2^bits,
+ * (P + 1) / 2^bits]; the terms common to both ends are certified for Pi.
+ * Shows the first terms and convergents, Khinchin's and Levy's constants as estimated from
+ * the terms (about 2.685 and 1.1866 for a typical number), and saves every term
+ * @param digits The number of decimal places to calculate
+ */
+void run_continued_fraction(int digits)
+{
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Continued fraction of Pi from " << digits << " digits" << endl;
+
+  mp_bitcnt_t previous_precision = mpf_get_default_prec();
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(digits * 3.32193);
+  mpf_set_default_prec(bits + 128);
+
+  struct timeval start;
+  gettimeofday(&start, nullptr);
+  mpf_class pi = calculate_pi_chudnovsky_binary_splitting(digits + CF_GUARD_DIGITS);
+  double calculation_seconds = elapsed_seconds(start);
+
+  // Truncate to a fixed-point integer; the guard digits keep the engine's error far below
+  // one unit, so widening the truncation by one unit on each side brackets Pi itself
+  mpf_class scaled(pi, mpf_get_default_prec());
+  mpf_mul_2exp(scaled.get_mpf_t(), pi.get_mpf_t(), bits);
+  mpz_class truncated(scaled);
+  mpz_class lower = truncated - 1;
+  mpz_class upper = truncated + 1;
+  mpz_class denominator = 1;
+  denominator <<= bits;
+  mpf_set_default_prec(previous_precision);
+
+  gettimeofday(&start, nullptr);
+  vector<unsigned long> terms;
+  mpz_class p, q;
+  continued_fraction_common_prefix(lower, denominator, upper, denominator, terms, p, q);
+  double expansion_seconds = elapsed_seconds(start);
+
+  cout << "Calculated Pi in " << calculation_seconds << " second(s)" << endl;
+  cout << "Expanded " << terms.size() << " certified term(s) in " << expansion_seconds << " second(s)" << endl;
+
+  if (terms.empty())
+  {
+    return;
+  }
+
+  cout << "\nTerms: [" << terms[0] << ";";
+  for (size_t i = 1; i < terms.size() && i < SHOWN_TERMS; ++i)
+  {
+    cout << " " << terms[i] << (i + 1 < terms.size() ? "," : "");
+  }
+  cout << (terms.size() > SHOWN_TERMS ? " ...]" : "]") << endl;
+
+  // Convergents from the recurrence p_k = a_k p_(k-1) + p_(k-2), likewise for q_k
+  cout << "Convergents:";
+  mpz_class p_previous = 1, q_previous = 0, p_current = terms[0], q_current = 1;
+  for (size_t i = 0; i < terms.size() && i < SHOWN_CONVERGENTS; ++i)
+  {
+    if (i > 0)
+    {
+      mpz_class p_next = p_current * terms[i] + p_previous;
+      mpz_class q_next = q_current * terms[i] + q_previous;
+      p_previous = p_current;
+      q_previous = q_current;
+      p_current = p_next;
+      q_current = q_next;
+    }
+    cout << " " << p_current << "/" << q_current;
+  }
+  cout << (terms.size() > SHOWN_CONVERGENTS ? " ..." : "") << endl;
+
+  // Statistics over the terms after the integer part
+  size_t largest = 1;
+  double log_sum = 0;
+  for (size_t i = 1; i < terms.size(); ++i)
+  {
+    if (terms[i] > terms[largest])
+    {
+      largest = i;
+    }
+    log_sum += log(static_cast<double>(terms[i]));
+  }
+
+  if (terms.size() > 1)
+  {
+    size_t count = terms.size() - 1;
+    cout << "Largest term: " << terms[largest] << " (term " << largest << ")" << endl;
+    cout << "Khinchin estimate (geometric mean of terms): " << exp(log_sum / count) << endl;
+    cout << "Levy estimate (ln q / terms): " << log_mpz(q) / count << endl;
+  }
+
+  cout << "Last convergent: " << mpz_sizeinbase(p.get_mpz_t(), 10) << "-digit numerator / "
+       << mpz_sizeinbase(q.get_mpz_t(), 10) << "-digit denominator" << endl;
+
+  save_terms(terms);
+}
+
+// EOF
@@ -0,0 +1,34 @@
+// continued_fraction.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CONTINUED_FRACTION_HPP
+#define CONTINUED_FRACTION_HPP
+
+#include <gmpxx.h>
+#include <vector>
+
+#define CF_BASE_BITS 1024  // Operand size below which terms are found with plain Euclidean steps
+#define CF_GUARD_DIGITS 20  // Digits calculated beyond the requested precision before truncating
+
+void continued_fraction_common_prefix(mpz_class a, mpz_class b, mpz_class c, mpz_class d,
+                                      std::vector<unsigned long> &terms, mpz_class &p, mpz_class &q);
+void run_continued_fraction(int digits);
+
+#endif
+
+// EOF
@@ -0,0 +1,269 @@
+// digit_cache.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "digit_cache.hpp"
+#include "output_writer.hpp"
+#include "utility.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define CACHE_HEADER_SIZE 128  // Upper bound on the length of an entry's header line
+
+// A cache entry as described by its header (the digits themselves stay on disk)
+struct CacheEntry{
+  string path;
+  int method;  // Engine that produced the digits
+  size_t digits;  // Certified decimal places stored in the entry
+  uint64_t checksum;  // FNV-1a of the decimal places
+};
+
+static size_t cache_limit = DIGIT_CACHE_DEFAULT_LIMIT;  // Maximum bytes the cache may use (0 disables it)
+
+/**
+ * Sets the size limit of the cache
+ * @param bytes The maximum number of bytes the cache may use, or 0 to disable the cache
+ */
+void set_digit_cache_limit(size_t bytes)
+{
+  cache_limit = bytes;
+}
+
+/**
+ * Returns the size limit of the cache
+ * @return The maximum number of bytes the cache may use, or 0 if the cache is disabled
+ */
+size_t get_digit_cache_limit()
+{
+  return cache_limit;
+}
+
+/**
+ * Returns the cache directory: "cache" in the storage root, or $WPCPP_CACHE_DIR on hosts
+ * @return The directory path
+ */
+static string cache_directory()
+{
+#ifndef GEKKO
+  const char *override_directory = getenv("WPCPP_CACHE_DIR");
+  if (override_directory && *override_directory)
+  {
+    return override_directory;
+  }
+#endif
+  return string(output_storage_root()) + "/cache";
+}
+
+/**
+ * Lists the entries in the cache directory, smallest first
+ * Files with a missing or unknown header are skipped
+ * @return The entries
+ */
+static vector<CacheEntry> list_entries()
+{
+  vector<CacheEntry> entries;
+  string directory_path = cache_directory();
+  DIR *directory = opendir(directory_path.c_str());
+  if (!directory)
+  {
+    return entries;
+  }
+
+  struct dirent *item;
+  while ((item = readdir(directory)) != nullptr)
+  {
+    size_t name_length = strlen(item->d_name);
+    if (strncmp(item->d_name, "pi_", 3) != 0 || name_length < 8 || strcmp(item->d_name + name_length - 4, ".txt") != 0)
+    {
+      continue;
+    }
+
+    CacheEntry entry;
+    entry.path = directory_path + "/" + item->d_name;
+    FILE *file = fopen(entry.path.c_str(), "rb");
+    if (!file)
+    {
+      continue;
+    }
+
+    char header[CACHE_HEADER_SIZE];
+    int version = 0;
+    unsigned long digits = 0;
+    unsigned long long checksum = 0;
+    if (fgets(header, sizeof(header), file) &&
+        sscanf(header, "WPCPP-CACHE %d method=%d digits=%lu fnv=%llx", &version, &entry.method, &digits, &checksum) == 4 &&
+        version == DIGIT_CACHE_VERSION)
+    {
+      entry.digits = digits;
+      entry.checksum = checksum;
+      entries.push_back(entry);
+    }
+    fclose(file);
+  }
+  closedir(directory);
+
+  sort(entries.begin(), entries.end(), [](const CacheEntry &a, const CacheEntry &b) { return a.digits < b.digits; });
+  return entries;
+}
+
+/**
+ * Returns how many decimal places the cache holds, according to the entry headers
+ * @return The largest cached precision (not yet verified), or 0 if the cache is empty or disabled
+ */
+size_t digit_cache_available()
+{
+  if (cache_limit == 0)
+  {
+    return 0;
+  }
+
+  vector<CacheEntry> entries = list_entries();
+  return entries.empty() ? 0 : entries.back().digits;
+}
+
+/**
+ * Reads and verifies a cache entry
+ * @param entry The entry
+ * @param digits Receives "3." followed by the entry's decimal places
+ * @return True if the entry is intact (its checksum matches)
+ */
+static bool read_entry(const CacheEntry &entry, string &digits)
+{
+  FILE *file = fopen(entry.path.c_str(), "rb");
+  if (!file)
+  {
+    return false;
+  }
+  setvbuf(file, nullptr, _IONBF, 0);  // The body is read in one piece
+
+  char header[CACHE_HEADER_SIZE];
+  bool intact = false;
+  if (fgets(header, sizeof(header), file))
+  {
+    digits.resize(entry.digits + 2);
+    intact = fread(&digits[0], 1, digits.size(), file) == digits.size() && digits.compare(0, 2, "3.") == 0 &&
+             hash_digits(digits.data() + 2, entry.digits) == entry.checksum;
+  }
+  fclose(file);
+  return intact;
+}
+
+/**
+ * Looks up digits of Pi in the cache
+ * The smallest entry that covers the request is read and verified against its checksum;
+ * a corrupt entry is deleted and the next larger one is tried
+ * @param digits The number of decimal places wanted
+ * @param result Receives "3." followed by exactly that many decimal places (empty on a miss)
+ * @return True if the cache could answer the request
+ */
+bool digit_cache_lookup(size_t digits, string &result)
+{
+  if (cache_limit == 0)
+  {
+    return false;
+  }
+
+  vector<CacheEntry> entries = list_entries();
+  for (const CacheEntry &entry : entries)
+  {
+    if (entry.digits < digits)
+    {
+      continue;
+    }
+
+    if (read_entry(entry, result))
+    {
+      result.resize(digits + 2);
+      return true;
+    }
+    remove(entry.path.c_str());
+  }
+  result.clear();  // Leave no partial entry behind
+  return false;
+}
+
+/**
+ * Stores certified digits of Pi in the cache
+ * Every entry is a prefix of the same number, so an entry makes all smaller ones
+ * redundant: those are evicted, which leaves a single entry. Results the cache already
+ * covers are not stored again, and a result larger than the size limit is stored
+ * truncated to the limit. The entry is written under a temporary name and renamed once
+ * complete, so an interrupted write never shows up as an entry
+ * @param method The engine that produced the digits
+ * @param digits "3." followed by the certified decimal places
+ * @return True if the cache now covers the digits (or as many of them as the limit allows)
+ */
+bool digit_cache_store(int method, const string &digits)
+{
+  if (cache_limit <= CACHE_HEADER_SIZE + 3 || digits.size() < 3 || digits.compare(0, 2, "3.") != 0)
+  {
+    return false;
+  }
+
+  size_t places = min(digits.size() - 2, cache_limit - CACHE_HEADER_SIZE - 3);
+  vector<CacheEntry> entries = list_entries();
+  if (!entries.empty() && entries.back().digits >= places)
+  {
+    return true;  // Already covered
+  }
+
+  string directory_path = cache_directory();
+  mkdir(directory_path.c_str(), 0777);
+
+  char name[64];
+  snprintf(name, sizeof(name), "/pi_%lu", static_cast<unsigned long>(places));
+  string temporary_path = directory_path + name + ".tmp";
+  string path = directory_path + name + ".txt";
+
+  OutputWriter *writer = output_writer_open(temporary_path.c_str(), false, CACHE_HEADER_SIZE + places + 3);
+  if (!writer)
+  {
+    return false;
+  }
+
+  char header[CACHE_HEADER_SIZE];
+  int header_length = snprintf(header, sizeof(header), "WPCPP-CACHE %d method=%d digits=%lu fnv=%016" PRIx64 "\n",
+                               DIGIT_CACHE_VERSION, method, static_cast<unsigned long>(places),
+                               hash_digits(digits.data() + 2, places));
+  bool written = output_writer_write(writer, header, header_length);
+  written = output_writer_write(writer, digits.data(), places + 2) && written;
+  written = output_writer_write(writer, "\n", 1) && written;
+  written = output_writer_close(writer, nullptr) && written;
+  if (!written || rename(temporary_path.c_str(), path.c_str()) != 0)
+  {
+    remove(temporary_path.c_str());
+    return false;
+  }
+
+  // Evict the entries the new one makes redundant
+  for (const CacheEntry &entry : entries)
+  {
+    remove(entry.path.c_str());
+  }
+  return true;
+}
+
+// EOF
@@ -0,0 +1,42 @@
+// digit_cache.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DIGIT_CACHE_HPP
+#define DIGIT_CACHE_HPP
+
+#include <cstddef>
+#include <string>
+
+#define DIGIT_CACHE_VERSION 1  // Entries with another version are ignored
+
+// Default size limit of the cache directory (can be changed with --cache-limit=<MiB>)
+#ifdef GEKKO
+#define DIGIT_CACHE_DEFAULT_LIMIT (16 * 1024 * 1024)
+#else
+#define DIGIT_CACHE_DEFAULT_LIMIT (1024 * 1024 * 1024)
+#endif
+
+void set_digit_cache_limit(size_t bytes);
+size_t get_digit_cache_limit();
+size_t digit_cache_available();
+bool digit_cache_lookup(size_t digits, std::string &result);
+bool digit_cache_store(int method, const std::string &digits);
+
+#endif
+
+// EOF
@@ -0,0 +1,133 @@
+// fixed_point.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fixed_point.hpp"
+#include "kernels.hpp"
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+/**
+ * Creates a zeroed fixed-point number large enough for the requested precision
+ * @param precision The number of decimal places the number must hold
+ * @return A zero-initialized fixed-point number (integer word, fraction words and guard words)
+ */
+FixedPoint fp_create(int precision)
+{
+  size_t fraction_words = (precision + FP_WORD_DIGITS - 1) / FP_WORD_DIGITS;
+  return FixedPoint(1 + fraction_words + FP_GUARD_WORDS, 0);
+}
+
+/**
+ * Precomputes the reciprocals of a small divisor for fp_div_step
+ * @param value The divisor (must be non-zero and below FP_MAX_DIVISOR)
+ * @return The divisor with its reciprocals
+ */
+FpDivisor fp_divisor(uint32_t value)
+{
+  FpDivisor divisor;
+  divisor.value = value;
+  divisor.inverse = 1.0 / value;
+  divisor.base_inverse = static_cast<double>(FP_BASE) / value;
+  return divisor;
+}
+
+/**
+ * Divides a fixed-point number by a small integer (dest = src / divisor)
+ * Words above 'first' are known to be zero and are skipped, which halves the work
+ * of a series whose terms keep shrinking. Those words of dest are left untouched,
+ * so callers should only read dest from the returned index onwards
+ * @param dest The quotient (may be the same object as src)
+ * @param src The dividend
+ * @param divisor The small integer divisor (non-zero and below FP_MAX_DIVISOR)
+ * @param first Index of the first word of src that may be non-zero
+ * @return Index of the first non-zero word of the quotient (dest.size() if it is zero)
+ */
+size_t fp_div_ui(FixedPoint &dest, const FixedPoint &src, uint32_t divisor, size_t first)
+{
+  size_t size = src.size();
+
+  // Long division from the most significant word down, carrying the remainder
+  FpDivisor reciprocal = fp_divisor(divisor);
+  uint32_t remainder = 0;
+  for (size_t i = first; i < size; ++i)
+  {
+    dest[i] = fp_div_step(remainder, src[i], reciprocal);
+  }
+
+  // Report where the quotient now starts so the caller can skip zero words next time
+  while (first < size && dest[first] == 0)
+  {
+    ++first;
+  }
+  return first;
+}
+
+/**
+ * Resolves the carries of an accumulator into a fixed-point number (dest = src)
+ * The value must not be negative
+ * @param dest Receives the normalized value (resized to match src)
+ * @param src The accumulator
+ */
+void fp_normalize(FixedPoint &dest, const FixedPointAccumulator &src)
+{
+  int64_t carry = 0;
+  dest.resize(src.size());
+
+  // From the least significant fraction word up, keeping each word in 0..10^9-1 (floor division)
+  for (size_t i = src.size(); i-- > 1;)
+  {
+    int64_t value = src[i] + carry;
+    carry = value / static_cast<int64_t>(FP_BASE);
+    value -= carry * static_cast<int64_t>(FP_BASE);
+    if (value < 0)
+    {
+      value += FP_BASE;
+      --carry;
+    }
+    dest[i] = static_cast<uint32_t>(value);
+  }
+
+  // What is left over belongs to the integer part
+  dest[0] = static_cast<uint32_t>(src[0] + carry);
+}
+
+/**
+ * Converts a fixed-point number into a "3.14159..." style string
+ * Since every word already holds 9 decimal digits, this is a straight word-to-ASCII
+ * pass with no radix conversion
+ * @param value The fixed-point number to convert
+ * @param precision The number of decimal places to emit (truncated, not rounded)
+ * @return The decimal representation of the value
+ */
+string fp_to_decimal(const FixedPoint &value, int precision)
+{
+  string result = to_string(value[0]);
+  size_t point = result.size();
+  size_t words = min(value.size() - 1, static_cast<size_t>((precision + FP_WORD_DIGITS - 1) / FP_WORD_DIGITS));
+  result.resize(point + 1 + words * FP_WORD_DIGITS);
+  result[point] = '.';
+
+  // Emit each fractional word as exactly 9 digits, most significant digit first
+  kernels.words_to_ascii(&value[1], words, &result[point + 1]);
+
+  // Truncate to exactly the number of decimal places requested
+  result.resize(point + 1 + precision);
+  return result;
+}
+
+// EOF
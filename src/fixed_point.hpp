@@ -0,0 +1,86 @@
+// fixed_point.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef FIXED_POINT_HPP
+#define FIXED_POINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define FP_BASE 1000000000u  // Each word holds 9 decimal digits (base 10^9)
+#define FP_WORD_DIGITS 9  // Decimal digits stored per word
+#define FP_GUARD_WORDS 2  // Extra low-order words that absorb truncation error
+#define FP_MAX_DIVISOR (1u << 30)  // Divisors must stay below this for fp_div_step
+#define FP_MAX_BATCH 4  // Most series terms sharing one pass over the words
+
+// A fixed-point number in base 10^9: word 0 is the integer part and
+// words 1..n-1 are the fractional part, most significant first
+typedef std::vector<uint32_t> FixedPoint;
+
+// The same layout with signed 64-bit words that may leave the 0..10^9-1 range, so many
+// values can be added or subtracted without carrying; fp_normalize resolves the carries
+typedef std::vector<int64_t> FixedPointAccumulator;
+
+// A small divisor with its reciprocals precomputed for fp_div_step
+struct FpDivisor{
+  uint32_t value;
+  double inverse;  // 1 / value
+  double base_inverse;  // 10^9 / value
+};
+
+/**
+ * Divides one step of a long division by a small divisor: (remainder * 10^9 + word) / divisor
+ * The quotient is estimated in double precision and corrected with 32-bit arithmetic, so
+ * no 64-bit division is needed (a library call on 32-bit PowerPC). The estimate is within
+ * one of the exact quotient, so the exact remainder lies in (-divisor, 2 * divisor) and
+ * can be computed modulo 2^32 as long as divisor < FP_MAX_DIVISOR
+ * @param remainder The remainder carried in from the previous word, updated in place
+ * @param word The next word of the dividend
+ * @param divisor The divisor, with its reciprocals
+ * @return The quotient word
+ */
+inline uint32_t fp_div_step(uint32_t &remainder, uint32_t word, const FpDivisor &divisor)
+{
+  uint32_t quotient = static_cast<uint32_t>(remainder * divisor.base_inverse + word * divisor.inverse);
+  int32_t exact = static_cast<int32_t>(remainder * FP_BASE + word - quotient * divisor.value);
+
+  if (exact < 0)
+  {
+    --quotient;
+    exact += divisor.value;
+  }
+  else if (static_cast<uint32_t>(exact) >= divisor.value)
+  {
+    ++quotient;
+    exact -= divisor.value;
+  }
+
+  remainder = static_cast<uint32_t>(exact);
+  return quotient;
+}
+
+FixedPoint fp_create(int precision);
+FpDivisor fp_divisor(uint32_t value);
+size_t fp_div_ui(FixedPoint &dest, const FixedPoint &src, uint32_t divisor, size_t first);
+void fp_normalize(FixedPoint &dest, const FixedPointAccumulator &src);
+std::string fp_to_decimal(const FixedPoint &value, int precision);
+
+#endif
+
+// EOF
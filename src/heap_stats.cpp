@@ -0,0 +1,169 @@
+// heap_stats.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "heap_stats.hpp"
+#include <gmp.h>
+#include <cstdlib>
+#include <malloc.h>
+#include <atomic>
+
+#ifdef GEKKO
+#include <gccore.h>
+#endif
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define HOST_PROBE_LIMIT (256u * 1024 * 1024)  // Hosts overcommit memory, so probes stop here
+
+// Atomic because the parallel multiply allocates from several threads at once
+static atomic<size_t> gmp_live_bytes(0);  // Bytes currently allocated through GMP
+static atomic<size_t> gmp_peak_bytes(0);  // Highest value gmp_live_bytes has reached
+
+/**
+ * Raises the recorded peak to a new live level if it is higher
+ * @param live The live level just reached
+ */
+static void update_gmp_peak(size_t live)
+{
+  size_t peak = gmp_peak_bytes.load();
+  while (live > peak && !gmp_peak_bytes.compare_exchange_weak(peak, live))
+  {
+  }
+}
+
+/**
+ * GMP allocation hook that counts the bytes it hands out
+ * @param size The number of bytes requested
+ * @return The allocated memory (GMP aborts on failure, as with its default allocator)
+ */
+static void *tracked_allocate(size_t size)
+{
+  void *block = malloc(size);
+  if (!block)
+  {
+    abort();
+  }
+  update_gmp_peak(gmp_live_bytes += size);
+  return block;
+}
+
+/**
+ * GMP reallocation hook; GMP passes the old size, so no allocation header is needed
+ * @param block The block to resize
+ * @param old_size The current size of the block
+ * @param new_size The requested size
+ * @return The resized memory
+ */
+static void *tracked_reallocate(void *block, size_t old_size, size_t new_size)
+{
+  void *resized = realloc(block, new_size);
+  if (!resized)
+  {
+    abort();
+  }
+  update_gmp_peak(gmp_live_bytes += new_size - old_size);
+  return resized;
+}
+
+/**
+ * GMP free hook
+ * @param block The block to free
+ * @param size The size of the block
+ */
+static void tracked_free(void *block, size_t size)
+{
+  free(block);
+  gmp_live_bytes -= size;
+}
+
+/**
+ * Routes GMP's allocations through counting wrappers
+ * Must be called before any GMP value is created, since blocks allocated earlier
+ * would be freed through the wrappers without having been counted
+ */
+void install_gmp_memory_tracking()
+{
+  mp_set_memory_functions(tracked_allocate, tracked_reallocate, tracked_free);
+}
+
+/**
+ * Restarts the GMP peak measurement from the current live level
+ */
+void reset_gmp_peak_bytes()
+{
+  gmp_peak_bytes = gmp_live_bytes.load();
+}
+
+/**
+ * Finds the largest block malloc can currently return by binary search
+ * Fragmentation shows up as this value shrinking while the free total stays put
+ * Neither newlib nor glibc report their largest free chunk (mallinfo only has totals), so
+ * this probes with malloc and free, which touches the heap it measures: every probe block
+ * is freed and coalesces back, but a probe served from the top of the heap can claim more
+ * of the arena until malloc trims it again, and hosts serve large probes with mmap. The
+ * free total is therefore read before probing, and the result is only as fine as
+ * HEAP_PROBE_GRANULARITY
+ * @param upper_bound No block larger than this is probed
+ * @return The largest allocatable size, rounded down to the probe granularity
+ */
+static size_t probe_largest_free_block(size_t upper_bound)
+{
+  size_t low = 0;  // Known to succeed
+  size_t high = upper_bound / HEAP_PROBE_GRANULARITY + 1;  // Known to fail (in granularity units)
+
+  while (high - low > 1)
+  {
+    size_t middle = low + (high - low) / 2;
+    void *block = malloc(middle * HEAP_PROBE_GRANULARITY);
+    if (block)
+    {
+      free(block);
+      low = middle;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low * HEAP_PROBE_GRANULARITY;
+}
+
+/**
+ * Takes a snapshot of the heap: free space, largest free block and GMP usage
+ * @return The current heap sample
+ */
+HeapSample sample_heap()
+{
+  HeapSample sample;
+  struct mallinfo info = mallinfo();
+  sample.free_bytes = static_cast<size_t>(info.fordblks);
+
+#ifdef GEKKO
+  // The heap grows into the unclaimed parts of the MEM1 and MEM2 arenas
+  sample.free_bytes += SYS_GetArena1Size() + SYS_GetArena2Size();
+  sample.largest_free_block = probe_largest_free_block(sample.free_bytes);
+#else
+  sample.largest_free_block = probe_largest_free_block(HOST_PROBE_LIMIT);
+#endif
+
+  sample.gmp_live_bytes = gmp_live_bytes;
+  sample.gmp_peak_bytes = gmp_peak_bytes;
+  return sample;
+}
+
+// EOF
@@ -0,0 +1,40 @@
+// heap_stats.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HEAP_STATS_HPP
+#define HEAP_STATS_HPP
+
+#include <cstddef>
+
+#define HEAP_PROBE_GRANULARITY (64 * 1024)  // Resolution of the largest-free-block probe
+
+// A snapshot of the heap state
+struct HeapSample{
+  size_t free_bytes;  // Free space inside the heap plus the arena not yet claimed by it
+  size_t largest_free_block;  // Largest single allocation that currently succeeds (probed with malloc/free)
+  size_t gmp_live_bytes;  // Bytes currently allocated by GMP
+  size_t gmp_peak_bytes;  // Highest GMP allocation level since tracking started
+};
+
+void install_gmp_memory_tracking();
+void reset_gmp_peak_bytes();
+HeapSample sample_heap();
+
+#endif
+
+// EOF
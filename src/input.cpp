@@ -19,6 +19,10 @@
 #include "input.hpp"
 #include <gccore.h>
 #include <wiiuse/wpad.h>
+#include <ogcsys.h>
+#include <iostream>
+#include <cstdlib>
+#include <time.h>
 
 // Global variables to track the state of inputs
 static u32 gc_last_state = 0;  // Store the previous state for GameCube controller
@@ -70,4 +74,46 @@ bool is_button_just_pressed(u32 gc_button, u32 wii_button)
     return gc_just_pressed || wii_just_pressed;
 }
 
+/**
+ * Exits the program and attempts to return to the Homebrew Channel or system menu
+ * Always waits for 3 seconds before exiting
+ */
+void exit_WPCPP()
+{
+  // Print exit message
+  std::cout << "\nExiting to Homebrew Channel..." << std::endl;
+
+  // Wait for 3 seconds before exiting
+  struct timespec req = {3, 0};  // 3 seconds sleep
+  nanosleep(&req, nullptr);
+
+  // Reset the system and return to Homebrew Channel (or system menu if Homebrew isn't available)
+  SYS_ResetSystem(SYS_RETURNTOMENU, 0, 0);
+
+  // Fallback in case the system reset fails
+  exit(1);
+}
+
+/**
+ * Waits until any button on a GameCube controller or Wii Remote is pressed
+ */
+void wait_for_user_input_to_return()
+{
+    std::cout << "Press any button to return to the menu." << std::endl;
+    while (true)
+    {
+      // Update the input states
+      poll_inputs();
+
+      // Check if any button on the GameCube controller or Wii Remote is pressed
+      if (is_button_just_pressed(0xFFFFFFFF, 0xFFFFFFFF))
+      {
+        break;
+      }
+
+      // Wait for video sync to ensure smooth input handling
+      VIDEO_WaitVSync();
+    }
+}
+
 // EOF
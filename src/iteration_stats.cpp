@@ -0,0 +1,231 @@
+// iteration_stats.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "iteration_stats.hpp"
+
+#ifdef WPCPP_ITERATION_STATS
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#ifdef GEKKO
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#else
+#include <time.h>
+#endif
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+// Durations of one loop's iterations, overall and per band of the iteration index
+struct LoopStats{
+  const char *name;
+  unsigned long histogram[ITERATION_STATS_BUCKETS];  // Iterations per power-of-two duration bucket
+  unsigned long band_count[ITERATION_STATS_K_BANDS];  // Iterations per band of k
+  uint64_t band_ticks[ITERATION_STATS_K_BANDS];  // Total duration per band of k
+  unsigned long count;
+  uint64_t total_ticks;
+  uint64_t max_ticks;
+};
+
+static LoopStats loops[ITERATION_STATS_MAX_LOOPS];
+static int num_loops = 0;
+
+/**
+ * Returns the index of the highest set bit plus one (0 for 0), used to pick log2 buckets
+ * @param value The value
+ * @return The bit length of value
+ */
+static int bit_length(uint64_t value)
+{
+  int length = 0;
+  while (value)
+  {
+    value >>= 1;
+    length++;
+  }
+  return length;
+}
+
+/**
+ * Converts time base ticks to microseconds
+ * @param ticks The duration in ticks
+ * @return The duration in microseconds
+ */
+static double ticks_to_us(uint64_t ticks)
+{
+#ifdef GEKKO
+  return ticks / (TB_TIMER_CLOCK / 1000.0);  // TB_TIMER_CLOCK is in ticks per millisecond
+#else
+  return ticks / 1000.0;  // Host ticks are nanoseconds
+#endif
+}
+
+/**
+ * Clears all loops before a new calculation
+ */
+void iteration_stats_reset()
+{
+  memset(loops, 0, sizeof(loops));
+  num_loops = 0;
+}
+
+/**
+ * Returns the index of a loop's statistics, registering the loop on first use
+ * Loops beyond ITERATION_STATS_MAX_LOOPS share the last slot
+ * @param name The loop's name (must stay valid until the statistics are printed)
+ * @return The loop index to pass to iteration_stats_record()
+ */
+int iteration_stats_loop(const char *name)
+{
+  for (int i = 0; i < num_loops; ++i)
+  {
+    if (strcmp(loops[i].name, name) == 0)
+    {
+      return i;
+    }
+  }
+
+  if (num_loops == ITERATION_STATS_MAX_LOOPS)
+  {
+    return ITERATION_STATS_MAX_LOOPS - 1;
+  }
+  loops[num_loops].name = name;
+  return num_loops++;
+}
+
+/**
+ * Reads the time base
+ * @return The current time in ticks (time base ticks on the Wii, nanoseconds on hosts)
+ */
+uint64_t iteration_stats_now()
+{
+#ifdef GEKKO
+  return gettime();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+/**
+ * Records one iteration that started at the given time and ends now
+ * @param loop The loop index from iteration_stats_loop()
+ * @param k The iteration index
+ * @param start The time the iteration started, from iteration_stats_now()
+ */
+void iteration_stats_record(int loop, unsigned long k, uint64_t start)
+{
+  uint64_t ticks = iteration_stats_now() - start;
+  LoopStats &stats = loops[loop];
+
+  int bucket = bit_length(ticks) - 1;
+  bucket = bucket < 0 ? 0 : (bucket >= ITERATION_STATS_BUCKETS ? ITERATION_STATS_BUCKETS - 1 : bucket);
+  int band = bit_length(k + 1) - 1;
+  band = band >= ITERATION_STATS_K_BANDS ? ITERATION_STATS_K_BANDS - 1 : band;
+
+  stats.histogram[bucket]++;
+  stats.band_count[band]++;
+  stats.band_ticks[band] += ticks;
+  stats.count++;
+  stats.total_ticks += ticks;
+  stats.max_ticks = ticks > stats.max_ticks ? ticks : stats.max_ticks;
+}
+
+/**
+ * Returns the upper bound of the bucket holding a percentile of a loop's iterations
+ * @param stats The loop
+ * @param fraction The percentile as a fraction (0.5 for the median)
+ * @return The duration bound in ticks
+ */
+static uint64_t percentile_ticks(const LoopStats &stats, double fraction)
+{
+  unsigned long target = static_cast<unsigned long>(ceil(stats.count * fraction));
+  unsigned long seen = 0;
+  for (int b = 0; b < ITERATION_STATS_BUCKETS; ++b)
+  {
+    seen += stats.histogram[b];
+    if (seen >= target && seen > 0)
+    {
+      uint64_t bound = (2ULL << b) - 1;
+      return bound < stats.max_ticks ? bound : stats.max_ticks;
+    }
+  }
+  return stats.max_ticks;
+}
+
+/**
+ * Prints the percentiles and the cost-vs-k curve of every loop that ran
+ * The curve gives the mean iteration cost per doubling of k and the growth exponent
+ * between consecutive bands: an exponent near 0 is a constant cost per term, near 1
+ * a cost linear in k (the loop as a whole turning quadratic), and so on
+ */
+void iteration_stats_print()
+{
+  // Fixed-point output for the tables; the stream's format is restored afterwards
+  ios::fmtflags previous_flags = cout.flags();
+  streamsize previous_precision = cout.precision();
+  cout << fixed;
+
+  for (int i = 0; i < num_loops; ++i)
+  {
+    const LoopStats &stats = loops[i];
+    if (stats.count == 0)
+    {
+      continue;
+    }
+
+    cout << "\nLoop '" << stats.name << "': " << stats.count << " iteration(s), " << setprecision(1)
+         << ticks_to_us(stats.total_ticks) << " us total" << endl;
+    cout << setprecision(2) << "  p50 <= " << ticks_to_us(percentile_ticks(stats, 0.50))
+         << " us, p90 <= " << ticks_to_us(percentile_ticks(stats, 0.90))
+         << " us, p99 <= " << ticks_to_us(percentile_ticks(stats, 0.99))
+         << " us, max " << ticks_to_us(stats.max_ticks) << " us" << endl;
+
+    cout << "  k range        mean us   growth" << endl;
+    double previous_mean = 0;
+    for (int band = 0; band < ITERATION_STATS_K_BANDS; ++band)
+    {
+      if (stats.band_count[band] == 0)
+      {
+        continue;
+      }
+
+      double mean = ticks_to_us(stats.band_ticks[band]) / stats.band_count[band];
+      unsigned long first_k = (1UL << band) - 1;
+      cout << "  " << right << setw(5) << first_k << "-" << left << setw(7) << 2 * first_k << " "
+           << right << setw(10) << mean;
+      if (previous_mean > 0 && mean > 0)
+      {
+        cout << "   k^" << log2(mean / previous_mean);  // Each band doubles k
+      }
+      cout << endl;
+      previous_mean = mean;
+    }
+  }
+
+  cout.flags(previous_flags);
+  cout.precision(previous_precision);
+}
+
+#endif
+
+// EOF
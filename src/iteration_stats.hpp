@@ -0,0 +1,53 @@
+// iteration_stats.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Per-iteration latency histograms: times every iteration of the engines' main loops with
+// the time base and buckets the durations by powers of two, per loop and per range of the
+// iteration index k. Enabled by building with ITERATION_STATS=1 (which defines
+// WPCPP_ITERATION_STATS); otherwise the calls below compile to nothing
+
+#ifndef ITERATION_STATS_HPP
+#define ITERATION_STATS_HPP
+
+#include <cstdint>
+
+#define ITERATION_STATS_MAX_LOOPS 8  // Distinct loops tracked per calculation
+#define ITERATION_STATS_BUCKETS 40  // Bucket b holds iterations of 2^b to 2^(b+1) - 1 ticks
+#define ITERATION_STATS_K_BANDS 32  // Band j holds iterations with k in [2^j - 1, 2^(j+1) - 1)
+
+#ifdef WPCPP_ITERATION_STATS
+
+void iteration_stats_reset();
+int iteration_stats_loop(const char *name);
+uint64_t iteration_stats_now();
+void iteration_stats_record(int loop, unsigned long k, uint64_t start);
+void iteration_stats_print();
+
+#else
+
+inline void iteration_stats_reset() {}
+inline int iteration_stats_loop(const char *) { return 0; }
+inline uint64_t iteration_stats_now() { return 0; }
+inline void iteration_stats_record(int, unsigned long, uint64_t) {}
+inline void iteration_stats_print() {}
+
+#endif
+
+#endif
+
+// EOF
@@ -0,0 +1,352 @@
+// kernels.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "kernels.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static const char *level_names[KERNEL_LEVEL_COUNT] = {"scalar", "word", "sse4.2", "avx2", "avx512"};
+
+// "00" to "99", so each division by 100 yields two digits (constant, so threads can share it)
+static const char digit_pairs[201] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+//---------------------------------------------------------------------------------
+// Scalar variants: always available, used as the reference for the others
+//---------------------------------------------------------------------------------
+
+/**
+ * Finds the first differing byte of two strings, one byte at a time
+ * @param a The first string
+ * @param b The second string
+ * @param length The number of bytes to compare
+ * @return The index of the first difference, or length if the strings match
+ */
+static size_t first_mismatch_scalar(const char *a, const char *b, size_t length)
+{
+  size_t i = 0;
+  while (i < length && a[i] == b[i])
+  {
+    ++i;
+  }
+  return i;
+}
+
+/**
+ * Writes base 10^9 words as ASCII, nine zero-padded digits per word, one division per digit
+ * @param words The words to convert
+ * @param count The number of words
+ * @param out Receives count * 9 characters (not terminated)
+ */
+static void words_to_ascii_scalar(const uint32_t *words, size_t count, char *out)
+{
+  for (size_t w = 0; w < count; ++w)
+  {
+    uint32_t word = words[w];
+    for (int d = 8; d >= 0; --d)
+    {
+      out[d] = static_cast<char>('0' + word % 10);
+      word /= 10;
+    }
+    out += 9;
+  }
+}
+
+//---------------------------------------------------------------------------------
+// Word variants: portable, compare 4 bytes at a time and convert two digits per division
+//---------------------------------------------------------------------------------
+
+/**
+ * Finds the first differing byte of two strings, four bytes at a time
+ * @param a The first string
+ * @param b The second string
+ * @param length The number of bytes to compare
+ * @return The index of the first difference, or length if the strings match
+ */
+static size_t first_mismatch_word(const char *a, const char *b, size_t length)
+{
+  size_t i = 0;
+
+  // memcpy keeps the loads legal for unaligned strings and compiles to a single load
+  for (; i + sizeof(uint32_t) <= length; i += sizeof(uint32_t))
+  {
+    uint32_t wa, wb;
+    memcpy(&wa, a + i, sizeof(wa));
+    memcpy(&wb, b + i, sizeof(wb));
+    if (wa != wb)
+    {
+      break;  // The mismatch is inside this word; the tail loop finds the byte
+    }
+  }
+
+  return i + first_mismatch_scalar(a + i, b + i, length - i);
+}
+
+/**
+ * Writes base 10^9 words as ASCII, nine zero-padded digits per word, two digits per division
+ * @param words The words to convert
+ * @param count The number of words
+ * @param out Receives count * 9 characters (not terminated)
+ */
+static void words_to_ascii_word(const uint32_t *words, size_t count, char *out)
+{
+  for (size_t w = 0; w < count; ++w)
+  {
+    uint32_t word = words[w];
+    for (int d = 7; d >= 1; d -= 2)
+    {
+      uint32_t pair = word % 100;
+      word /= 100;
+      out[d] = digit_pairs[2 * pair];
+      out[d + 1] = digit_pairs[2 * pair + 1];
+    }
+    out[0] = static_cast<char>('0' + word);  // Leading digit of the 9
+    out += 9;
+  }
+}
+
+//---------------------------------------------------------------------------------
+// x86 variants: compiled for their target with function attributes, selected at runtime
+//---------------------------------------------------------------------------------
+
+#ifdef KERNELS_X86
+
+/**
+ * Finds the first differing byte of two strings, 16 bytes at a time
+ * @param a The first string
+ * @param b The second string
+ * @param length The number of bytes to compare
+ * @return The index of the first difference, or length if the strings match
+ */
+__attribute__((target("sse4.2")))
+static size_t first_mismatch_sse42(const char *a, const char *b, size_t length)
+{
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16)
+  {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    unsigned int equal = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+    if (equal != 0xFFFF)
+    {
+      return i + __builtin_ctz(~equal);
+    }
+  }
+  return i + first_mismatch_scalar(a + i, b + i, length - i);
+}
+
+/**
+ * Converts eight digits (value < 10^8) to their values in eight 16-bit lanes
+ * The value is split into two halves of four digits, each half is broadcast to four lanes
+ * and divided by 1000, 100, 10 and 1 with multiply-high steps, and the digit in front of
+ * each lane is then subtracted out
+ * @param value The eight digits
+ * @return The digits' values, most significant in the lowest lane
+ */
+__attribute__((target("sse4.2")))
+static inline __m128i eight_digits_sse42(uint32_t value)
+{
+  uint32_t high = value / 10000;
+  uint32_t low = value - high * 10000;
+
+  // [high, low] in 16-bit lanes, times 4 so the first multiply-high keeps enough bits
+  __m128i halves = _mm_slli_epi64(_mm_unpacklo_epi16(_mm_cvtsi32_si128(high), _mm_cvtsi32_si128(low)), 2);
+  __m128i lanes = _mm_unpacklo_epi32(_mm_unpacklo_epi16(halves, halves), _mm_unpacklo_epi16(halves, halves));
+
+  // Divide by 10^3, 10^2, 10^1 and 10^0: [a, ab, abc, abcd, e, ef, efg, efgh]
+  const __m128i reciprocals = _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768);
+  const __m128i shifts = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768);
+  __m128i prefixes = _mm_mulhi_epu16(_mm_mulhi_epu16(lanes, reciprocals), shifts);
+
+  // Subtract 10 times the lane in front: [a, b, c, d, e, f, g, h]
+  __m128i tens = _mm_slli_epi64(_mm_mullo_epi16(prefixes, _mm_set1_epi16(10)), 16);
+  return _mm_sub_epi16(prefixes, tens);
+}
+
+/**
+ * Writes base 10^9 words as ASCII, nine zero-padded digits per word, with the last eight
+ * digits of each word computed in parallel lanes
+ * @param words The words to convert
+ * @param count The number of words
+ * @param out Receives count * 9 characters (not terminated)
+ */
+__attribute__((target("sse4.2")))
+static void words_to_ascii_sse42(const uint32_t *words, size_t count, char *out)
+{
+  const __m128i zeros = _mm_set1_epi8('0');
+  for (size_t w = 0; w < count; ++w)
+  {
+    uint32_t word = words[w];
+    uint32_t leading = word / 100000000;
+    out[0] = static_cast<char>('0' + leading);
+
+    __m128i digits = _mm_packus_epi16(eight_digits_sse42(word - leading * 100000000), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 1), _mm_add_epi8(digits, zeros));
+    out += 9;
+  }
+}
+
+/**
+ * Finds the first differing byte of two strings, 32 bytes at a time
+ * @param a The first string
+ * @param b The second string
+ * @param length The number of bytes to compare
+ * @return The index of the first difference, or length if the strings match
+ */
+__attribute__((target("avx2")))
+static size_t first_mismatch_avx2(const char *a, const char *b, size_t length)
+{
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32)
+  {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    unsigned int equal = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    if (equal != 0xFFFFFFFFu)
+    {
+      return i + __builtin_ctz(~equal);
+    }
+  }
+  return i + first_mismatch_scalar(a + i, b + i, length - i);
+}
+
+/**
+ * Finds the first differing byte of two strings, 64 bytes at a time
+ * @param a The first string
+ * @param b The second string
+ * @param length The number of bytes to compare
+ * @return The index of the first difference, or length if the strings match
+ */
+__attribute__((target("avx512f,avx512bw")))
+static size_t first_mismatch_avx512(const char *a, const char *b, size_t length)
+{
+  size_t i = 0;
+  for (; i + 64 <= length; i += 64)
+  {
+    __m512i va = _mm512_loadu_si512(a + i);
+    __m512i vb = _mm512_loadu_si512(b + i);
+    unsigned long long differ = _mm512_cmpneq_epi8_mask(va, vb);
+    if (differ != 0)
+    {
+      return i + __builtin_ctzll(differ);
+    }
+  }
+  return i + first_mismatch_scalar(a + i, b + i, length - i);
+}
+
+#endif
+
+// The active kernels, portable until initialize_kernels() picks the best variant
+KernelTable kernels = {KERNEL_LEVEL_WORD, first_mismatch_word, words_to_ascii_word};
+
+/**
+ * Detects the best kernel level the running CPU supports
+ * Broadway (and any non-x86 CPU) has no runtime-variable vector units, so it uses the word kernels
+ * @return The highest supported kernel level
+ */
+KernelLevel detect_kernel_level()
+{
+#ifdef KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+  {
+    return KERNEL_LEVEL_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return KERNEL_LEVEL_AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2"))
+  {
+    return KERNEL_LEVEL_SSE42;
+  }
+#endif
+  return KERNEL_LEVEL_WORD;
+}
+
+/**
+ * Fills the kernel table for the detected level, or for a forced level when benchmarking
+ * A forced level above what the CPU supports is rejected and the detected level is used
+ * @param forced_level Name of the level to force (e.g. "scalar", "avx2"), or nullptr to auto-detect
+ * @return False if the forced level was unknown or unsupported
+ */
+bool initialize_kernels(const char *forced_level)
+{
+  KernelLevel detected = detect_kernel_level();
+  KernelLevel level = detected;
+  bool accepted = true;
+
+  if (forced_level)
+  {
+    accepted = false;
+    for (int i = 0; i < KERNEL_LEVEL_COUNT; ++i)
+    {
+      if (strcmp(forced_level, level_names[i]) == 0 && i <= detected)
+      {
+        level = static_cast<KernelLevel>(i);
+        accepted = true;
+      }
+    }
+  }
+
+  kernels.level = level;
+  kernels.first_mismatch = (level == KERNEL_LEVEL_SCALAR) ? first_mismatch_scalar : first_mismatch_word;
+  kernels.words_to_ascii = (level == KERNEL_LEVEL_SCALAR) ? words_to_ascii_scalar : words_to_ascii_word;
+
+#ifdef KERNELS_X86
+  // Digit conversion works on one word (eight lanes) at a time, so the SSE4.2 variant serves every x86 level
+  if (level >= KERNEL_LEVEL_SSE42)
+  {
+    kernels.words_to_ascii = words_to_ascii_sse42;
+  }
+  if (level == KERNEL_LEVEL_SSE42)
+  {
+    kernels.first_mismatch = first_mismatch_sse42;
+  }
+  else if (level == KERNEL_LEVEL_AVX2)
+  {
+    kernels.first_mismatch = first_mismatch_avx2;
+  }
+  else if (level == KERNEL_LEVEL_AVX512)
+  {
+    kernels.first_mismatch = first_mismatch_avx512;
+  }
+#endif
+
+  return accepted;
+}
+
+/**
+ * Returns the printable name of a kernel level
+ * @param level The kernel level
+ * @return The level's name, as accepted by initialize_kernels()
+ */
+const char *kernel_level_name(KernelLevel level)
+{
+  return level_names[level];
+}
+
+// EOF
@@ -0,0 +1,50 @@
+// kernels.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernel variants, from the most portable to the widest vector units
+enum KernelLevel{
+  KERNEL_LEVEL_SCALAR,  // One byte or digit at a time
+  KERNEL_LEVEL_WORD,  // Word-at-a-time comparison and two-digit table conversion (best on Broadway)
+  KERNEL_LEVEL_SSE42,  // x86 hosts with SSE4.2
+  KERNEL_LEVEL_AVX2,  // x86 hosts with AVX2
+  KERNEL_LEVEL_AVX512,  // x86 hosts with AVX-512BW
+  KERNEL_LEVEL_COUNT
+};
+
+// Function pointers for the selected variant of each kernel
+struct KernelTable{
+  KernelLevel level;  // The level the table was filled for
+  size_t (*first_mismatch)(const char *a, const char *b, size_t length);  // Index of the first differing byte, or length
+  void (*words_to_ascii)(const uint32_t *words, size_t count, char *out);  // Writes 9 digits per base 10^9 word
+};
+
+extern KernelTable kernels;
+
+KernelLevel detect_kernel_level();
+bool initialize_kernels(const char *forced_level);
+const char *kernel_level_name(KernelLevel level);
+
+#endif
+
+// EOF
@@ -20,29 +20,137 @@
 #include <iostream>
 #include "video.hpp"
 #include "pi_calculation.hpp"
+#include "pi_display.hpp"
+#include "binary_splitting.hpp"
 #include "menu.hpp"
 #include "utility.hpp"
 #include "input.hpp"
+#include "output_writer.hpp"
+#include "kernels.hpp"
+#include "heap_stats.hpp"
+#include "soak.hpp"
+#include "time_budget.hpp"
+#include "benchmark.hpp"
+#include "verify.hpp"
+#include "continued_fraction.hpp"
+#include "digit_cache.hpp"
+#include "parallel_arithmetic.hpp"
+#include <cstring>
+#include <cstdlib>
 
 /**
  * Main function that runs the Pi calculation loop
  * Initializes the video system, displays menus for configuring, and performs
- * Pi calculations based on input until the user exits the program
+ * Pi calculations (or the soak test) based on input until the user exits the program
  */
 int main(int argc, char **argv)
 {
+  // Count GMP's allocations for the soak test (must happen before any GMP value exists)
+  install_gmp_memory_tracking();
+
+  // Pick the best digit kernels for this CPU, unless "--kernel=<level>" forces one for benchmarking,
+  // take the file for the verify mode from "--verify=<path>", the digit cache's size limit from
+  // "--cache-limit=<MiB>" and the thread count of the parallel multiply on hosts from "--threads=<n>"
+  // (arguments can be passed from the Homebrew Channel through meta.xml)
+  const char *forced_kernel = nullptr;
+  const char *verify_path = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strncmp(argv[i], "--kernel=", 9) == 0)
+    {
+      forced_kernel = argv[i] + 9;
+    }
+    else if (strncmp(argv[i], "--verify=", 9) == 0)
+    {
+      verify_path = argv[i] + 9;
+    }
+    else if (strncmp(argv[i], "--cache-limit=", 14) == 0)
+    {
+      set_digit_cache_limit(static_cast<size_t>(atol(argv[i] + 14)) * 1024 * 1024);  // In MiB, 0 disables the cache
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      set_parallel_threads(atoi(argv[i] + 10));  // 0 means one per core; ignored on the Wii
+    }
+  }
+  bool kernel_accepted = initialize_kernels(forced_kernel);
+
   // Initialize the video system and prepare the display
   initialize_video();
 
   // Initialize inputs for Wii Remote and GameCube Controllers
   initialize_inputs();
 
+  // Mount the SD card so results and logs can be saved (the program still runs without one)
+  initialize_output_storage();
+
+  // A forced kernel level is reported once the console is up, along with the level actually used
+  if (forced_kernel)
+  {
+    if (!kernel_accepted)
+    {
+      std::cout << "Kernel level '" << forced_kernel << "' is unknown or not supported by this CPU." << std::endl;
+    }
+    std::cout << "Using the " << kernel_level_name(kernels.level) << " kernels." << std::endl;
+    wait_for_user_input_to_return();
+  }
+
   // Main loop to keep the program running until the user decides to exit
   while (true)
   {
+    // Prompt the user to select what to do
+    int mode = mode_selection_menu();
+
+    // The soak test runs every method repeatedly and reports heap trends
+    if (mode == 1)
+    {
+      run_soak_test();
+      wait_for_user_input_to_return();
+      continue;
+    }
+
+    // The time-budgeted mode picks its own engine and precision to fit the deadline
+    if (mode == 2)
+    {
+      run_time_budget(time_budget_selection_menu());
+      wait_for_user_input_to_return();
+      continue;
+    }
+
+    // The benchmark runs a fixed workload so scores from different machines are comparable
+    if (mode == 3)
+    {
+      run_benchmark();
+      wait_for_user_input_to_return();
+      continue;
+    }
+
+    // The verifier checks a digit file from another tool (pi_verify.txt unless given with --verify=)
+    if (mode == 4)
+    {
+      run_verifier(verify_path);
+      wait_for_user_input_to_return();
+      continue;
+    }
+
+    // The continued fraction mode expands a computed Pi into its terms and convergents
+    if (mode == 5)
+    {
+      run_continued_fraction(continued_fraction_selection_menu());
+      wait_for_user_input_to_return();
+      continue;
+    }
+
     // Prompt the user to select a method for calculating Pi and a desired precision level
     int method = method_selection_menu();
-    int precision = precision_selection_menu();
+    int precision = precision_selection_menu(method);
+
+    // The binary splitting method (8) can run in bounded-memory segments, so ask for the cap
+    // (the menu only offers limits that can hold the fixed-point state at this precision)
+    if (method == 8)
+    {
+      set_binary_splitting_memory_limit(memory_limit_selection_menu(precision));
+    }
 
     // Dynamically set GMP precision (number of bits) based on user input of how many digits of pi they want to calculate
     // 3.32 bits per decimal place is an approximation
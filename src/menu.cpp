@@ -18,6 +18,7 @@
 
 #include "menu.hpp"
 #include "utility.hpp"
+#include "binary_splitting.hpp"
 #include <gccore.h>
 #include <wiiuse/wpad.h>
 #include <iostream>
@@ -28,22 +29,13 @@ using namespace std;  // Use the entire std namespace for simplicity
 /**
  * Displays a menu and allows the user to navigate and select options
  * The options are navigated using Left/Right on the D-pad, and 'A' selects the option
+ * @param title The heading shown above the instructions
+ * @param options The names of the options
+ * @param num_options The number of options
  * @return The index of the selected option
  */
-int method_selection_menu()
+static int option_selection_menu(const char *title, const string options[], int num_options)
 {
-  // Array of Pi calculation methods
-  string pi_methods[] = {
-    "Numerical Integration",
-    "Machin's Formula",
-    "Ramanujan's First Series",
-    "Chudnovsky Algorithm",
-    "Gauss-Legendre Algorithm",
-    "Spigot Algorithm",
-    "Bailey-Borwein-Plouffe (BBP) Formula"
-  };
-
-  int num_methods = sizeof(pi_methods) / sizeof(pi_methods[0]);
   int selected_index = 0;
 
   // Track the previous state of buttons to detect state changes
@@ -53,7 +45,7 @@ int method_selection_menu()
 
   // Clear the screen and display instructions
   cout << "\x1b[2J"; // ANSI escape code to clear the screen
-  cout << "Select Pi Calculation Method:\n";
+  cout << title << "\n";
   cout << "Use Left/Right on the D-pad to navigate.\n";
   cout << "Press 'A' to confirm.\n";
   cout << "Press 'Home' on Wii Remote or 'Start' on GameCube controller to exit.\n";
@@ -61,7 +53,7 @@ int method_selection_menu()
   // Variable to hold the length of the longest string to clear
   int max_length = 50;  // Define a max length for clearing output
 
-  // Loop until the user selects a method or exits
+  // Loop until the user selects an option or exits
   while (true)
   {
     // Poll inputs once per loop iteration to update the global input states
@@ -72,21 +64,21 @@ int method_selection_menu()
     bool button_left_down = is_button_just_pressed(PAD_BUTTON_LEFT, WPAD_BUTTON_LEFT);
     bool button_a_down = is_button_just_pressed(PAD_BUTTON_A, WPAD_BUTTON_A);
 
-    // Navigate to the right method
+    // Navigate to the option on the right
     if (button_right_down && !button_right_last)
     {
-      if (selected_index < num_methods - 1)  // Ensure it doesn't go out of bounds
+      if (selected_index < num_options - 1)  // Ensure it doesn't go out of bounds
       {
-        selected_index++;  // Move to the next method
+        selected_index++;  // Move to the next option
       }
     }
 
-    // Navigate to the left method
+    // Navigate to the option on the left
     if (button_left_down && !button_left_last)
     {
       if (selected_index > 0)  // Ensure it doesn't go below 0
       {
-        selected_index--;  // Move to the previous method
+        selected_index--;  // Move to the previous option
       }
     }
 
@@ -96,12 +88,12 @@ int method_selection_menu()
 
     // Clear the previous line by overwriting it with spaces, then reprint the currently selected method
     cout << "\rCurrently Selected: " << string(max_length, ' ') << "\r";  // Clear previous line
-    cout << "Currently Selected: " << pi_methods[selected_index] << "\r"; // Print new selection
+    cout << "Currently Selected: " << options[selected_index] << "\r"; // Print new selection
 
     // Confirm selection when 'A' button is pressed
     if (button_a_down && !button_a_last)
     {
-      return selected_index;  // Return the selected method index
+      return selected_index;  // Return the selected option index
     }
 
     // Update the last state of the 'A' button
@@ -118,14 +110,62 @@ int method_selection_menu()
   }
 }
 
+/**
+ * Displays the top-level menu for choosing what the program should do
+ * @return The index of the selected mode (0 = calculate Pi, 1 = soak test, 2 = time budget, 3 = benchmark,
+ *         4 = verify, 5 = continued fraction)
+ */
+int mode_selection_menu()
+{
+  string modes[] = {
+    "Calculate Pi",
+    "Soak Test (All Methods)",
+    "Time Budget (Max Digits)",
+    "Benchmark",
+    "Verify Digit File",
+    "Continued Fraction of Pi"
+  };
+
+  return option_selection_menu("Select Mode:", modes, sizeof(modes) / sizeof(modes[0]));
+}
+
+/**
+ * Displays the menu for choosing the Pi calculation method
+ * @return The index of the selected method
+ */
+int method_selection_menu()
+{
+  // Array of Pi calculation methods
+  string pi_methods[] = {
+    "Numerical Integration",
+    "Machin's Formula",
+    "Ramanujan's First Series",
+    "Chudnovsky Algorithm",
+    "Gauss-Legendre Algorithm",
+    "Spigot Algorithm",
+    "Bailey-Borwein-Plouffe (BBP) Formula",
+    "Machin's Formula (Base 10^9 Fixed-Point)",
+    "Chudnovsky Algorithm (Binary Splitting)",
+    "BBP Formula (Binary Splitting)",
+    "Gauss-Legendre Algorithm (Fixed-Point)"
+  };
+
+  return option_selection_menu("Select Pi Calculation Method:", pi_methods, sizeof(pi_methods) / sizeof(pi_methods[0]));
+}
+
 /**
  * Displays a precision selection screen to allow the user to choose the number
  * of decimal places for the Pi calculation
- * @return The selected precision (between 1 and 50 decimal places)
+ * The fixed-iteration methods (0-6) are limited to 50 decimal places, the
+ * arbitrary-precision methods (7 and up) to ARBITRARY_PRECISION_MAX_DIGITS
+ * @param method The selected calculation method
+ * @return The selected precision (between 1 and the method's limit)
  */
-int precision_selection_menu()
+int precision_selection_menu(int method)
 {
-  int precision = 50;  // Start with maximum precision (50 decimal places)
+  int max_precision = method >= 7 ? ARBITRARY_PRECISION_MAX_DIGITS : 50;
+  int max_step_size = method >= 7 ? ARBITRARY_PRECISION_MAX_DIGITS / 10 : 10;
+  int precision = 50;  // Start with 50 decimal places (the maximum of the fixed-iteration methods)
   int step_size = 1;   // Initial step size for adjusting precision
 
   // Track the previous state of buttons to detect state changes
@@ -137,7 +177,7 @@ int precision_selection_menu()
 
   // Clear the screen and display instructions
   cout << "\x1b[2J";  // ANSI escape code to clear the screen
-  cout << "Select Pi Precision (1-50 decimal places):\n";
+  cout << "Select Pi Precision (1-" << max_precision << " decimal places):\n";
   cout << "Use Left/Right on the D-pad to adjust.\n";
   cout << "Press 'L'/'R' or '-'/'+' to change the stepping size.\n";
   cout << "Press 'A' to confirm.\n";
@@ -167,7 +207,7 @@ int precision_selection_menu()
     // Increase step size by a factor of 10 if the R trigger or "+" button is pressed
     if (button_r_down && !button_r_last)
     {
-      if (step_size < 10)  // Ensure step size doesn't exceed 10
+      if (step_size < max_step_size)  // Ensure step size doesn't exceed the limit
       {
         step_size *= 10;  // Increase step size
       }
@@ -182,10 +222,10 @@ int precision_selection_menu()
       }
     }
 
-    // Increase precision if the right D-pad button is pressed, ensuring it stays <= 50
+    // Increase precision if the right D-pad button is pressed, ensuring it stays within the method's limit
     if (button_right_down && !button_right_last)
     {
-      if (precision + step_size <= 50)  // Ensure precision doesn't exceed 50
+      if (precision + step_size <= max_precision)  // Ensure precision doesn't exceed the limit
       {
         precision += step_size;  // Increase precision
       }
@@ -214,4 +254,142 @@ int precision_selection_menu()
   }
 }
 
+/**
+ * Displays the menu for choosing how long the time-budgeted mode may run
+ * @return The selected budget in seconds
+ */
+int time_budget_selection_menu()
+{
+  const int budgets[] = {1, 2, 5, 10, 30, 60, 300};
+  string labels[] = {
+    "1 second",
+    "2 seconds",
+    "5 seconds",
+    "10 seconds",
+    "30 seconds",
+    "1 minute",
+    "5 minutes"
+  };
+
+  return budgets[option_selection_menu("Select Time Budget:", labels, sizeof(labels) / sizeof(labels[0]))];
+}
+
+/**
+ * Displays the menu for choosing how many digits the continued fraction mode expands
+ * Roughly one certified term is found per decimal digit
+ * @return The selected number of decimal places
+ */
+int continued_fraction_selection_menu()
+{
+  const int sizes[] = {1000, 10000, 100000, 1000000};
+  string labels[] = {
+    "1,000 digits",
+    "10,000 digits",
+    "100,000 digits",
+    "1,000,000 digits"
+  };
+
+  return sizes[option_selection_menu("Select Continued Fraction Precision:", labels, sizeof(labels) / sizeof(labels[0]))];
+}
+
+/**
+ * Displays a memory limit selection screen for the segmented binary splitting mode
+ * The limit caps how much memory the calculation may use; smaller limits use more,
+ * smaller blocks and run somewhat slower. Limits too small for the fixed-point state
+ * of the selected precision are skipped
+ * @param precision The selected number of decimal places
+ * @return The selected limit in bytes, or 0 for no limit (a single full tree)
+ */
+size_t memory_limit_selection_menu(int precision)
+{
+  // Selectable limits in KiB, doubling from 256 KiB up to 64 MiB (0 means unlimited)
+  const size_t limits_kib[] = {0, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536};
+  int num_limits = sizeof(limits_kib) / sizeof(limits_kib[0]);
+  int selected_index = 0;
+
+  // Find the first limit that can hold the fixed-point state at this precision
+  size_t full_kib = estimate_binary_splitting_bytes(precision) / 1024 + 1;
+  size_t minimum_kib = estimate_binary_splitting_minimum_bytes(precision) / 1024 + 1;
+  int first_usable = 1;
+  while (first_usable < num_limits && limits_kib[first_usable] < minimum_kib)
+  {
+    first_usable++;
+  }
+
+  // Track the previous state of buttons to detect state changes
+  bool button_a_last = false;
+  bool button_left_last = false;
+  bool button_right_last = false;
+
+  // Clear the screen and display instructions
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Select Binary Splitting Memory Limit:\n";
+  cout << "A single tree needs about " << full_kib << " KiB; segments need at least " << minimum_kib << " KiB.\n";
+  cout << "Use Left/Right on the D-pad to adjust.\n";
+  cout << "Press 'A' to confirm.\n";
+
+  // Loop until the user confirms their memory limit selection
+  while (true)
+  {
+    // Poll inputs once per loop iteration to update the global input states
+    poll_inputs();
+
+    // Check if specific buttons are pressed
+    bool button_left_down = is_button_just_pressed(PAD_BUTTON_LEFT, WPAD_BUTTON_LEFT);
+    bool button_right_down = is_button_just_pressed(PAD_BUTTON_RIGHT, WPAD_BUTTON_RIGHT);
+    bool button_a_down = is_button_just_pressed(PAD_BUTTON_A, WPAD_BUTTON_A);
+
+    // Move to a smaller limit, going from the first usable one back to unlimited
+    if (button_left_down && !button_left_last && selected_index > 0)
+    {
+      selected_index = (selected_index > first_usable) ? selected_index - 1 : 0;
+    }
+
+    // Move to a larger limit, skipping the ones too small for this precision
+    if (button_right_down && !button_right_last)
+    {
+      if (selected_index == 0 && first_usable < num_limits)
+      {
+        selected_index = first_usable;
+      }
+      else if (selected_index > 0 && selected_index < num_limits - 1)
+      {
+        selected_index++;
+      }
+    }
+
+    // Update last button states for the next iteration
+    button_left_last = button_left_down;
+    button_right_last = button_right_down;
+
+    // Display the current memory limit
+    cout << "\rCurrent Limit: ";
+    if (limits_kib[selected_index] == 0)
+    {
+      cout << "Unlimited (single tree)";
+    }
+    else if (limits_kib[selected_index] < 1024)
+    {
+      cout << limits_kib[selected_index] << " KiB";
+    }
+    else
+    {
+      cout << limits_kib[selected_index] / 1024 << " MiB";
+    }
+    cout << "          \r";
+
+    // Confirm selection when 'A' button is pressed
+    if (button_a_down && !button_a_last)
+    {
+      return limits_kib[selected_index] * 1024;  // Return the selected limit in bytes
+    }
+
+    // Update the last state of the 'A' button
+    button_a_last = button_a_down;
+
+    // Wait for video sync to ensure smooth input handling
+    VIDEO_WaitVSync();
+  }
+}
+
 // EOF
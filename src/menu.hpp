@@ -19,8 +19,16 @@
 #ifndef MENU_HPP
 #define MENU_HPP
 
+#include <cstddef>
+
+#define ARBITRARY_PRECISION_MAX_DIGITS 1000000  // Largest precision offered for methods 7 and up
+
+int mode_selection_menu();
 int method_selection_menu();
-int precision_selection_menu();
+int precision_selection_menu(int method);
+size_t memory_limit_selection_menu(int precision);
+int time_budget_selection_menu();
+int continued_fraction_selection_menu();
 
 #endif
 
@@ -0,0 +1,374 @@
+// output_writer.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "output_writer.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#ifdef GEKKO
+#include <gccore.h>
+#include <fat.h>
+#include <malloc.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef GEKKO
+#define STORAGE_ROOT "sd:/apps/WPCPP"  // The app's own folder on the SD card
+#define FLUSH_THREAD_STACK_SIZE (16 * 1024)
+#define FLUSH_THREAD_PRIORITY 80  // Above the main thread (64) so a flush starts as soon as a buffer is handed over
+#else
+#define STORAGE_ROOT "."  // Host backend writes next to the working directory
+#endif
+
+static bool storage_ready = false;  // Set once the output storage has been mounted
+
+// Double-buffered writer state shared between the producer and the flush thread
+struct OutputWriter{
+  FILE *file;  // Destination file, written only by the flush thread
+  unsigned char *buffers[2];  // Aligned buffers, one filled by the producer while the other is flushed
+  size_t buffer_size;  // Bytes per buffer
+  size_t fill[2];  // Number of bytes in each buffer
+  bool pending[2];  // True while a buffer is handed over to the flush thread
+  int active;  // Index of the buffer the producer is filling
+  bool closing;  // Set once the producer has handed over its last buffer
+  std::atomic<bool> failed;  // Set if any write to the file came up short (read by the producer without the lock)
+  uint64_t bytes_written;  // Bytes successfully written so far
+  unsigned int producer_stalls;  // Times the producer waited for a free buffer
+  struct timeval start_time;  // When the writer was opened
+#ifdef GEKKO
+  lwp_t thread;
+  mutex_t lock;
+  cond_t changed;
+#else
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+#endif
+};
+
+//---------------------------------------------------------------------------------
+// Platform backends: LWP threads and memalign on the Wii, POSIX threads on a host
+//---------------------------------------------------------------------------------
+
+#ifdef GEKKO
+
+static void *allocate_buffer(size_t size)
+{
+  return memalign(OUTPUT_BUFFER_ALIGNMENT, size);
+}
+
+static void writer_lock(OutputWriter *w)
+{
+  LWP_MutexLock(w->lock);
+}
+
+static void writer_unlock(OutputWriter *w)
+{
+  LWP_MutexUnlock(w->lock);
+}
+
+static void writer_wait(OutputWriter *w)
+{
+  LWP_CondWait(w->changed, w->lock);
+}
+
+static void writer_notify(OutputWriter *w)
+{
+  LWP_CondBroadcast(w->changed);
+}
+
+static bool writer_start(OutputWriter *w, void *(*entry)(void *))
+{
+  LWP_MutexInit(&w->lock, false);
+  LWP_CondInit(&w->changed);
+  return LWP_CreateThread(&w->thread, entry, w, nullptr, FLUSH_THREAD_STACK_SIZE, FLUSH_THREAD_PRIORITY) == 0;
+}
+
+static void writer_join(OutputWriter *w)
+{
+  LWP_JoinThread(w->thread, nullptr);
+  LWP_CondDestroy(w->changed);
+  LWP_MutexDestroy(w->lock);
+}
+
+#else
+
+static void *allocate_buffer(size_t size)
+{
+  return aligned_alloc(OUTPUT_BUFFER_ALIGNMENT, size);
+}
+
+static void writer_lock(OutputWriter *w)
+{
+  pthread_mutex_lock(&w->lock);
+}
+
+static void writer_unlock(OutputWriter *w)
+{
+  pthread_mutex_unlock(&w->lock);
+}
+
+static void writer_wait(OutputWriter *w)
+{
+  pthread_cond_wait(&w->changed, &w->lock);
+}
+
+static void writer_notify(OutputWriter *w)
+{
+  pthread_cond_broadcast(&w->changed);
+}
+
+static bool writer_start(OutputWriter *w, void *(*entry)(void *))
+{
+  pthread_mutex_init(&w->lock, nullptr);
+  pthread_cond_init(&w->changed, nullptr);
+  return pthread_create(&w->thread, nullptr, entry, w) == 0;
+}
+
+static void writer_join(OutputWriter *w)
+{
+  pthread_join(w->thread, nullptr);
+  pthread_cond_destroy(&w->changed);
+  pthread_mutex_destroy(&w->lock);
+}
+
+#endif
+
+/**
+ * Initializes the storage used for output files (mounts the SD card on the Wii)
+ * @return True if output files can be written
+ */
+bool initialize_output_storage()
+{
+#ifdef GEKKO
+  storage_ready = fatInitDefault();
+#else
+  storage_ready = true;
+#endif
+  return storage_ready;
+}
+
+/**
+ * Returns the directory output files are written to
+ * @return The storage root path, without a trailing slash
+ */
+const char *output_storage_root()
+{
+  return STORAGE_ROOT;
+}
+
+/**
+ * Background thread that writes handed-over buffers to the file in order
+ * Buffers alternate, so the thread always flushes the oldest pending one next
+ * @param arg The writer whose buffers should be flushed
+ * @return Always nullptr
+ */
+static void *flush_thread(void *arg)
+{
+  OutputWriter *w = static_cast<OutputWriter *>(arg);
+  int next = 0;  // Index of the next buffer to flush
+
+  writer_lock(w);
+  while (true)
+  {
+    // Sleep until the next buffer is handed over or the producer is done
+    while (!w->pending[next] && !w->closing)
+    {
+      writer_wait(w);
+    }
+
+    if (!w->pending[next])
+    {
+      break;  // Closing and nothing left to flush
+    }
+
+    // Write without holding the lock so the producer can keep filling the other buffer
+    size_t size = w->fill[next];
+    writer_unlock(w);
+    size_t written = fwrite(w->buffers[next], 1, size, w->file);
+    writer_lock(w);
+
+    if (written != size)
+    {
+      w->failed = true;
+    }
+    w->bytes_written += written;
+    w->fill[next] = 0;
+    w->pending[next] = false;
+    writer_notify(w);  // Wake a producer waiting for this buffer
+
+    next ^= 1;
+  }
+  writer_unlock(w);
+
+  return nullptr;
+}
+
+/**
+ * Frees everything owned by a writer
+ * @param w The writer to release
+ */
+static void free_writer(OutputWriter *w)
+{
+  free(w->buffers[0]);
+  free(w->buffers[1]);
+  delete w;
+}
+
+/**
+ * Opens a file for buffered background writing
+ * Small outputs get buffers sized to the payload instead of the full OUTPUT_BUFFER_SIZE
+ * @param path The file to write
+ * @param append True to append to an existing file instead of replacing it
+ * @param expected_size The number of bytes that will be written if known, or 0 for full-size buffers
+ * @return The writer, or nullptr if the storage, the file or the buffers could not be set up
+ */
+OutputWriter *output_writer_open(const char *path, bool append, size_t expected_size)
+{
+  if (!storage_ready)
+  {
+    return nullptr;
+  }
+
+  // Round the buffer up to the alignment, which the aligned allocators require
+  size_t buffer_size = OUTPUT_BUFFER_SIZE;
+  if (expected_size > 0 && expected_size < OUTPUT_BUFFER_SIZE)
+  {
+    buffer_size = (expected_size + OUTPUT_BUFFER_ALIGNMENT - 1) / OUTPUT_BUFFER_ALIGNMENT * OUTPUT_BUFFER_ALIGNMENT;
+  }
+
+  OutputWriter *w = new OutputWriter();
+  w->buffer_size = buffer_size;
+  w->buffers[0] = static_cast<unsigned char *>(allocate_buffer(buffer_size));
+  w->buffers[1] = static_cast<unsigned char *>(allocate_buffer(buffer_size));
+  w->file = (w->buffers[0] && w->buffers[1]) ? fopen(path, append ? "ab" : "wb") : nullptr;
+
+  if (!w->file)
+  {
+    free_writer(w);
+    return nullptr;
+  }
+
+  // Our buffers are already large, so skip the C library's extra copy
+  setvbuf(w->file, nullptr, _IONBF, 0);
+
+  gettimeofday(&w->start_time, nullptr);
+
+  if (!writer_start(w, flush_thread))
+  {
+    fclose(w->file);
+    free_writer(w);
+    return nullptr;
+  }
+  return w;
+}
+
+/**
+ * Hands the active buffer to the flush thread and switches to the other one
+ * The producer only waits here if the other buffer is still being flushed
+ * @param w The writer
+ */
+static void hand_over_active_buffer(OutputWriter *w)
+{
+  writer_lock(w);
+  w->pending[w->active] = true;
+  writer_notify(w);
+
+  w->active ^= 1;
+  if (w->pending[w->active])
+  {
+    w->producer_stalls++;  // Both buffers are full: back-pressure from the SD card
+    while (w->pending[w->active])
+    {
+      writer_wait(w);
+    }
+  }
+  writer_unlock(w);
+}
+
+/**
+ * Queues data for writing; it is copied into the active buffer and flushed in the background
+ * @param writer The writer
+ * @param data The bytes to write
+ * @param size The number of bytes to write
+ * @return False if an earlier flush failed
+ */
+bool output_writer_write(OutputWriter *writer, const void *data, size_t size)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+  while (size > 0)
+  {
+    size_t space = writer->buffer_size - writer->fill[writer->active];
+    size_t chunk = (size < space) ? size : space;
+
+    memcpy(writer->buffers[writer->active] + writer->fill[writer->active], bytes, chunk);
+    writer->fill[writer->active] += chunk;
+    bytes += chunk;
+    size -= chunk;
+
+    if (writer->fill[writer->active] == writer->buffer_size)
+    {
+      hand_over_active_buffer(writer);
+    }
+  }
+
+  return !writer->failed;  // Atomic, so no lock is needed; a failure still in flight is reported by the next call
+}
+
+/**
+ * Flushes the remaining data, waits for the flush thread and closes the file
+ * @param writer The writer (freed by this call)
+ * @param stats Receives the throughput statistics (may be nullptr)
+ * @return True if every byte was written successfully
+ */
+bool output_writer_close(OutputWriter *writer, OutputWriterStats *stats)
+{
+  writer_lock(writer);
+  if (writer->fill[writer->active] > 0)
+  {
+    writer->pending[writer->active] = true;  // Hand over the partially filled last buffer
+  }
+  writer->closing = true;
+  writer_notify(writer);
+  writer_unlock(writer);
+
+  writer_join(writer);
+  bool closed = (fclose(writer->file) == 0);
+  bool ok = !writer->failed && closed;
+
+  if (stats)
+  {
+    struct timeval end_time;
+    gettimeofday(&end_time, nullptr);
+
+    stats->bytes_written = writer->bytes_written;
+    stats->seconds = (end_time.tv_sec - writer->start_time.tv_sec) + (end_time.tv_usec - writer->start_time.tv_usec) / 1000000.0;
+    stats->megabytes_per_second = (stats->seconds > 0) ? (writer->bytes_written / (1024.0 * 1024.0)) / stats->seconds : 0.0;
+    stats->producer_stalls = writer->producer_stalls;
+  }
+
+  free_writer(writer);
+  return ok;
+}
+
+// EOF
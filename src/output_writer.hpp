@@ -0,0 +1,46 @@
+// output_writer.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OUTPUT_WRITER_HPP
+#define OUTPUT_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#define OUTPUT_BUFFER_SIZE (512 * 1024)  // Bytes per buffer (two are allocated per writer, smaller for small outputs)
+#define OUTPUT_BUFFER_ALIGNMENT 32  // Cache-line alignment for the buffers handed to the SD driver
+
+// Statistics reported when a writer is closed
+struct OutputWriterStats{
+  uint64_t bytes_written;  // Total bytes written to the file
+  double seconds;  // Time from opening to the final flush completing
+  double megabytes_per_second;  // Achieved throughput
+  unsigned int producer_stalls;  // Times the producer had to wait because both buffers were full
+};
+
+struct OutputWriter;  // Opaque double-buffered writer with a background flush thread
+
+bool initialize_output_storage();
+const char *output_storage_root();
+OutputWriter *output_writer_open(const char *path, bool append, size_t expected_size = 0);
+bool output_writer_write(OutputWriter *writer, const void *data, size_t size);
+bool output_writer_close(OutputWriter *writer, OutputWriterStats *stats);
+
+#endif
+
+// EOF
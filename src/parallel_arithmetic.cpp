@@ -0,0 +1,329 @@
+// parallel_arithmetic.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef GEKKO
+
+#include "parallel_arithmetic.hpp"
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define NEWTON_GUARD_BITS 64  // Extra bits carried by each Newton step so one step suffices
+
+static int requested_threads = 0;  // Set by the user; 0 means one per online core
+
+// One product computed on its own thread
+struct MultiplyTask{
+  mpz_t result;
+  mpz_srcptr a;
+  mpz_srcptr b;
+  int depth;
+  pthread_t thread;
+  bool started;  // False if the thread could not be created and the product was computed inline
+};
+
+/**
+ * Sets how many threads the parallel operations may use
+ * @param threads The number of threads, or 0 for one per online core
+ */
+void set_parallel_threads(int threads)
+{
+  requested_threads = threads;
+}
+
+/**
+ * Returns how many threads the parallel operations use
+ * @return The number of threads
+ */
+int get_parallel_threads()
+{
+  if (requested_threads > 0)
+  {
+    return requested_threads;
+  }
+
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? static_cast<int>(cores) : 1;
+}
+
+/**
+ * Returns how many levels of three-way splitting the thread count supports
+ * One level runs three half-size products at once, two levels nine quarter-size ones
+ * @return The number of levels (0 means a plain serial product)
+ */
+static int split_depth()
+{
+  int threads = get_parallel_threads();
+  if (threads >= 9)
+  {
+    return 2;
+  }
+  return threads >= PARALLEL_MIN_THREADS ? 1 : 0;
+}
+
+static void multiply(mpz_ptr result, mpz_srcptr a, mpz_srcptr b, int depth);
+
+/**
+ * Thread entry point that computes one task's product
+ * @param argument The task
+ * @return Unused
+ */
+static void *multiply_entry(void *argument)
+{
+  MultiplyTask *task = static_cast<MultiplyTask *>(argument);
+  multiply(task->result, task->a, task->b, task->depth);
+  return nullptr;
+}
+
+/**
+ * Starts computing a product on a new thread (or inline if no thread can be created)
+ * @param task The task to fill in and start
+ * @param a The first factor, which must stay unchanged until the task finishes
+ * @param b The second factor, likewise
+ * @param depth The split levels left for this product
+ */
+static void start_task(MultiplyTask &task, mpz_srcptr a, mpz_srcptr b, int depth)
+{
+  mpz_init(task.result);
+  task.a = a;
+  task.b = b;
+  task.depth = depth;
+  task.started = pthread_create(&task.thread, nullptr, multiply_entry, &task) == 0;
+  if (!task.started)
+  {
+    multiply(task.result, a, b, depth);
+  }
+}
+
+/**
+ * Waits for a task's product
+ * @param task The task to wait for; its result stays valid until cleared by the caller
+ */
+static void finish_task(MultiplyTask &task)
+{
+  if (task.started)
+  {
+    pthread_join(task.thread, nullptr);
+  }
+}
+
+/**
+ * Multiplies two integers, splitting the product across threads
+ * Balanced operands are split in halves at a limb boundary, a = a1 * 2^s + a0, and
+ * multiplied Karatsuba style: a0 * b0 and a1 * b1 on two new threads while this one forms
+ * (a0 + a1) * (b0 + b1), each of them split again while depth remains. The halves keep
+ * the sign of their operand, so the identity holds for negative values too. If one
+ * operand is under half the other's size, only the larger one is split and the two
+ * partial products run side by side
+ * @param result Receives a * b (may alias either operand)
+ * @param a The first factor
+ * @param b The second factor
+ * @param depth The split levels left
+ */
+static void multiply(mpz_ptr result, mpz_srcptr a, mpz_srcptr b, int depth)
+{
+  size_t size_a = mpz_size(a);
+  size_t size_b = mpz_size(b);
+
+  if (depth == 0 || min(size_a, size_b) < PARALLEL_THRESHOLD_LIMBS)
+  {
+    mpz_mul(result, a, b);
+    return;
+  }
+
+  bool square = (a == b);
+  if (size_a < size_b)
+  {
+    swap(a, b);
+    swap(size_a, size_b);
+  }
+
+  mp_bitcnt_t shift = static_cast<mp_bitcnt_t>(size_a / 2) * GMP_NUMB_BITS;
+  mpz_t a0, a1, low, sum_a, sum_b;
+  mpz_inits(a0, a1, low, sum_a, sum_b, nullptr);
+  mpz_tdiv_r_2exp(a0, a, shift);
+  mpz_tdiv_q_2exp(a1, a, shift);
+
+  if (size_b <= size_a / 2)
+  {
+    // result = (a1 * b) * 2^s + a0 * b
+    MultiplyTask high;
+    start_task(high, a1, b, depth - 1);
+    multiply(low, a0, b, depth - 1);
+    finish_task(high);
+
+    mpz_mul_2exp(result, high.result, shift);
+    mpz_add(result, result, low);
+    mpz_clear(high.result);
+  }
+  else
+  {
+    // result = z2 * 2^2s + (z1 - z0 - z2) * 2^s + z0
+    mpz_t b0, b1;
+    mpz_inits(b0, b1, nullptr);
+    if (!square)
+    {
+      mpz_tdiv_r_2exp(b0, b, shift);
+      mpz_tdiv_q_2exp(b1, b, shift);
+    }
+    mpz_srcptr low_b = square ? a0 : b0;
+    mpz_srcptr high_b = square ? a1 : b1;
+
+    MultiplyTask z0, z2;
+    start_task(z0, a0, low_b, depth - 1);
+    start_task(z2, a1, high_b, depth - 1);
+
+    mpz_add(sum_a, a0, a1);
+    if (square)
+    {
+      multiply(low, sum_a, sum_a, depth - 1);
+    }
+    else
+    {
+      mpz_add(sum_b, b0, b1);
+      multiply(low, sum_a, sum_b, depth - 1);
+    }
+
+    finish_task(z0);
+    finish_task(z2);
+
+    mpz_sub(low, low, z0.result);
+    mpz_sub(low, low, z2.result);
+    mpz_mul_2exp(result, z2.result, 2 * shift);
+    mpz_mul_2exp(low, low, shift);
+    mpz_add(result, result, low);
+    mpz_add(result, result, z0.result);
+    mpz_clears(b0, b1, z0.result, z2.result, nullptr);
+  }
+
+  mpz_clears(a0, a1, low, sum_a, sum_b, nullptr);
+}
+
+/**
+ * Approximates 2^(2k) / d by Newton's iteration, to within a few units
+ * The reciprocal of d's top half is found recursively, scaled up, and refined once with
+ * x += x * (2^(2k) - d * x) / 2^(2k), which doubles its correct bits; the guard bits
+ * cover the truncation of d and of the recursive result
+ * @param x Receives the approximation
+ * @param d The divisor, with exactly k bits
+ * @param k The bit length of d
+ * @param depth The split levels for the products
+ */
+static void reciprocal(mpz_ptr x, mpz_srcptr d, mp_bitcnt_t k, int depth)
+{
+  if (k <= static_cast<mp_bitcnt_t>(PARALLEL_THRESHOLD_LIMBS) * GMP_NUMB_BITS)
+  {
+    mpz_set_ui(x, 0);
+    mpz_setbit(x, 2 * k);
+    mpz_tdiv_q(x, x, d);
+    return;
+  }
+
+  mp_bitcnt_t half = k / 2 + NEWTON_GUARD_BITS;
+  mpz_t top, error;
+  mpz_inits(top, error, nullptr);
+
+  mpz_tdiv_q_2exp(top, d, k - half);
+  reciprocal(x, top, half, depth);
+  mpz_mul_2exp(x, x, k - half);
+
+  multiply(error, d, x, depth);
+  mpz_set_ui(top, 0);
+  mpz_setbit(top, 2 * k);
+  mpz_sub(error, top, error);
+  multiply(error, x, error, depth);
+  mpz_fdiv_q_2exp(error, error, 2 * k);
+  mpz_add(x, x, error);
+
+  mpz_clears(top, error, nullptr);
+}
+
+/**
+ * Divides non-negative n by positive d with Newton's reciprocal, so the work is products
+ * The reciprocal is taken at enough bits for the whole quotient, the estimate is made
+ * exact with one remainder correction (the estimate is off by a few units at most, but
+ * the correction is a full floor division of the remainder, so it is exact regardless)
+ * @param q Receives floor(n / d) (may alias n or d)
+ * @param n The dividend
+ * @param d The divisor
+ * @param depth The split levels for the products
+ */
+static void divide(mpz_ptr q, mpz_srcptr n, mpz_srcptr d, int depth)
+{
+  mp_bitcnt_t k = mpz_sizeinbase(d, 2);
+  mp_bitcnt_t n_bits = mpz_sizeinbase(n, 2);
+
+  if (mpz_size(d) < PARALLEL_THRESHOLD_LIMBS || n_bits < k)
+  {
+    mpz_tdiv_q(q, n, d);
+    return;
+  }
+
+  // x ~ 2^(2p) / (d * 2^(p - k)) = 2^(p + k) / d, with p covering the quotient's bits
+  mp_bitcnt_t p = max(k, n_bits - k) + NEWTON_GUARD_BITS;
+  mpz_t x, estimate, remainder, correction;
+  mpz_inits(x, estimate, remainder, correction, nullptr);
+
+  mpz_mul_2exp(remainder, d, p - k);
+  reciprocal(x, remainder, p, depth);
+  multiply(estimate, n, x, depth);
+  mpz_fdiv_q_2exp(estimate, estimate, p + k);
+
+  multiply(remainder, estimate, d, depth);
+  mpz_sub(remainder, n, remainder);
+  mpz_fdiv_qr(correction, remainder, remainder, d);
+  mpz_add(q, estimate, correction);
+
+  mpz_clears(x, estimate, remainder, correction, nullptr);
+}
+
+/**
+ * Multiplies two integers, across threads when they are large enough and cores allow
+ * @param result Receives a * b (may alias either operand)
+ * @param a The first factor
+ * @param b The second factor
+ */
+void parallel_mpz_mul(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_MUL, census_limbs(a, b));
+  multiply(result, a, b, split_depth());
+}
+
+/**
+ * Divides two integers, rounding toward zero; large non-negative divisions on hosts with
+ * enough cores use Newton's reciprocal built on the parallel product
+ * @param result Receives a / b (may alias either operand)
+ * @param a The dividend
+ * @param b The divisor
+ */
+void parallel_mpz_tdiv_q(mpz_ptr result, mpz_srcptr a, mpz_srcptr b)
+{
+  census_record(CENSUS_DIV, census_limbs(a, b));
+  if (get_parallel_threads() < PARALLEL_NEWTON_MIN_THREADS || mpz_sgn(a) < 0 || mpz_sgn(b) <= 0)
+  {
+    mpz_tdiv_q(result, a, b);
+    return;
+  }
+  divide(result, a, b, split_depth());
+}
+
+#endif
+
+// EOF
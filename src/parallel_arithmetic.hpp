@@ -0,0 +1,54 @@
+// parallel_arithmetic.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Threaded big-number multiplication and division for host builds. The top merges of
+// binary splitting, the AGM's products and the final division are single huge operations
+// that subtree parallelism can't split, so above a size threshold these spread one
+// operation across cores. Square roots stay on GMP: a Newton root built from these does
+// about nine times the work of mpz_sqrt. Broadway is single-core, so on the Wii these are
+// the plain GMP calls
+
+#ifndef PARALLEL_ARITHMETIC_HPP
+#define PARALLEL_ARITHMETIC_HPP
+
+#include "census.hpp"
+#include <gmp.h>
+
+#define PARALLEL_THRESHOLD_LIMBS 8192  // Smaller operands are not worth the thread start-up cost
+#define PARALLEL_MIN_THREADS 3  // A three-way split needs three cores to finish sooner than one product
+#define PARALLEL_NEWTON_MIN_THREADS 9  // Newton division does about four times the work of mpz_tdiv_q, so it needs a nine-way split
+
+#ifdef GEKKO
+
+inline void set_parallel_threads(int) {}
+inline int get_parallel_threads() { return 1; }
+inline void parallel_mpz_mul(mpz_ptr result, mpz_srcptr a, mpz_srcptr b) { census_mpz_mul(result, a, b); }
+inline void parallel_mpz_tdiv_q(mpz_ptr result, mpz_srcptr a, mpz_srcptr b) { census_mpz_tdiv_q(result, a, b); }
+
+#else
+
+void set_parallel_threads(int threads);
+int get_parallel_threads();
+void parallel_mpz_mul(mpz_ptr result, mpz_srcptr a, mpz_srcptr b);
+void parallel_mpz_tdiv_q(mpz_ptr result, mpz_srcptr a, mpz_srcptr b);
+
+#endif
+
+#endif
+
+// EOF
@@ -17,17 +17,59 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "pi_calculation.hpp"
-#include "utility.hpp"
+#include "fixed_point.hpp"
+#include "census.hpp"
+#include "parallel_arithmetic.hpp"
+#include "iteration_stats.hpp"
 #include <gmpxx.h>
 #include <iostream>
 #include <cmath>
-#include <sys/time.h>
-#include <gccore.h>
-#include <wiiuse/wpad.h>
 #include <random>
 
 using namespace std;  // Use the entire std namespace for simplicity
 
+#define CANCEL_CHECK_INTERVAL 32  // Series terms between progress reports and cancellation checks
+#define GAUSS_LEGENDRE_GUARD_BITS 64  // Extra fixed-point bits that absorb the truncation of each step
+
+static CalculationHooks calculation_hooks = {nullptr, nullptr, nullptr};  // Callbacks of the current calculation
+static bool cancel_requested = false;  // Latched once the cancel callback has returned true
+
+/**
+ * Installs the progress and cancellation callbacks for the following calculations
+ * @param hooks The callbacks to use, or nullptr to remove them
+ */
+void set_calculation_hooks(const CalculationHooks *hooks)
+{
+  calculation_hooks = hooks ? *hooks : CalculationHooks{nullptr, nullptr, nullptr};
+  cancel_requested = false;
+}
+
+/**
+ * Reports the completed fraction of the current calculation to the progress callback, if any
+ * @param fraction The completed fraction, from 0 to 1
+ */
+void report_calculation_progress(double fraction)
+{
+  if (calculation_hooks.progress)
+  {
+    calculation_hooks.progress(fraction, calculation_hooks.user_data);
+  }
+}
+
+/**
+ * Checks whether the current calculation should stop early
+ * Once the cancel callback has returned true, this keeps returning true until new hooks are set
+ * @return True if the calculation was cancelled
+ */
+bool calculation_cancelled()
+{
+  if (!cancel_requested && calculation_hooks.cancel)
+  {
+    cancel_requested = calculation_hooks.cancel(calculation_hooks.user_data);
+  }
+  return cancel_requested;
+}
+
 /**
  * Computes the arctangent using a Taylor series approximation
  * This function is crucial for the Machin's formula calculation of Pi
@@ -44,13 +86,16 @@ mpf_class arctan(const mpf_class &x)
   // NOTE: In the future, threshold should not be hardcoded
   // Threshold for stopping the iteration (precision set to 1e-50)
   mpf_class threshold("1e-50");  // Controls precision vs. performance: adjust this value to change the trade-off
+  int loop = iteration_stats_loop("arctan");  // Per-term timing (only in ITERATION_STATS=1 builds)
 
   // Loop while the absolute value of the term is greater than the threshold
   while (term > threshold || term < -threshold)  // Equivalent to abs(term) > threshold
   {
+    uint64_t iteration_start = iteration_stats_now();
     result += term;  // Add the current term to the result
     n += 2;  // Increase n by 2 (since the series uses odd numbers)
     term *= -x2 * (n - 2) / n;  // Compute the next term efficiently without recalculating powers
+    iteration_stats_record(loop, n / 2 - 1, iteration_start);
   }
 
   return result;  // Return the final result of the arctangent
@@ -86,15 +131,143 @@ mpf_class calculate_pi_machin()
   return 16 * arctan(mpf_class(1) / mpf_class(5)) - 4 * arctan(mpf_class(1) / mpf_class(239));
 }
 
+/**
+ * Accumulates multiplier * arctan(1/x) into a base 10^9 fixed-point sum
+ * Every term of the series is produced with small-integer divisions only:
+ * term k is power / (2k+1) with power = multiplier / x^(2k+1). Several terms share one
+ * pass over the words: term j of a batch is power / (x^(2j) * (2k+2j+1)) and the next
+ * batch's power is power / x^(2 batch), so every division in the pass works on the same
+ * word of power and none waits for another's remainder. Batches are as large as keeps
+ * each divisor below FP_MAX_DIVISOR (up to FP_MAX_BATCH terms). The terms are added to
+ * an accumulator without carrying, so each word of power is read and written once per pass
+ * @param sum The fixed-point accumulator
+ * @param multiplier The constant factor in front of the arctangent
+ * @param x The reciprocal of the arctangent argument (small integer)
+ * @param subtract True to subtract the arctangent from the sum instead of adding it
+ * @param progress_start Fraction of the whole calculation completed before this series
+ * @param progress_span Fraction of the whole calculation this series accounts for
+ * @return False if the calculation was cancelled before the series finished
+ */
+static bool arctan_inverse_fixed_point(FixedPointAccumulator &sum, uint32_t multiplier, uint32_t x, bool subtract,
+                                       double progress_start, double progress_span)
+{
+  size_t size = sum.size();
+  FixedPoint power(size, 0);  // multiplier / x^(2k+1) for the first term k of the batch
+  uint32_t x2 = x * x;  // Divisor between consecutive powers
+
+  power[0] = multiplier;
+  size_t first = fp_div_ui(power, power, x, 0);  // Index of the first non-zero word of power
+  int loop = iteration_stats_loop(x == 5 ? "fixed-point arctan(1/5)" : "fixed-point arctan(1/239)");
+  unsigned int unchecked_terms = 0;
+
+  // Loop until the power underflows the guard words, alternating the sign of each term
+  for (uint32_t n = 1; first < size;)
+  {
+    uint64_t iteration_start = iteration_stats_now();
+    FpDivisor term_divisors[FP_MAX_BATCH];
+    uint32_t term_remainders[FP_MAX_BATCH];
+    bool add_term[FP_MAX_BATCH];
+    uint32_t scale = 1;  // x^(2j) for term j of the batch
+    int batch = 0;
+
+    do
+    {
+      term_divisors[batch] = fp_divisor(scale * (n + 2 * batch));
+      term_remainders[batch] = 0;
+      add_term[batch] = (((n / 2 + batch) % 2) == 0) != subtract;  // Alternate signs, flipped for a subtracted arctangent
+      scale *= x2;
+      ++batch;
+    }
+    while (batch < FP_MAX_BATCH && static_cast<uint64_t>(scale) * x2 < FP_MAX_DIVISOR &&
+           static_cast<uint64_t>(scale) * (n + 2 * batch) < FP_MAX_DIVISOR);
+
+    FpDivisor power_divisor = fp_divisor(scale);
+    uint32_t power_remainder = 0;
+
+    for (size_t i = first; i < size; ++i)
+    {
+      uint32_t word = power[i];
+      int64_t terms = 0;
+      for (int j = 0; j < batch; ++j)
+      {
+        int64_t quotient = fp_div_step(term_remainders[j], word, term_divisors[j]);
+        terms += add_term[j] ? quotient : -quotient;
+      }
+      sum[i] += terms;
+      power[i] = fp_div_step(power_remainder, word, power_divisor);
+    }
+
+    // Census: one small-integer division per term and one for the next power, and one addition
+    census_record(CENSUS_SMALL, (batch + 1) * (size - first));
+    census_record(CENSUS_ADD, size - first);
+    iteration_stats_record(loop, n / 2, iteration_start);
+
+    n += 2 * batch;
+    while (first < size && power[first] == 0)
+    {
+      ++first;
+    }
+
+    // The leading zero words grow linearly with the term index, so they measure progress
+    unchecked_terms += batch;
+    if (unchecked_terms >= CANCEL_CHECK_INTERVAL)
+    {
+      unchecked_terms = 0;
+      report_calculation_progress(progress_start + progress_span * first / size);
+      if (calculation_cancelled())
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Calculates Pi using Machin's formula without GMP, on arrays of base 10^9 words
+ * Only small-integer divisions, additions and subtractions are needed, and because the
+ * result is already in a decimal base, printing it is a direct word-to-ASCII pass
+ * @param precision The number of decimal places of Pi to calculate
+ * @return The calculated value of Pi as a "3.14159..." string, or an empty string if
+ *         cancelled or beyond the engine's range
+ */
+string calculate_pi_machin_fixed_point(int precision)
+{
+  // The arctan(1/5) series divides by about 1.43 * precision, which must stay below FP_MAX_DIVISOR
+  if (precision > static_cast<int>(FP_MAX_DIVISOR / 2))
+  {
+    return string();
+  }
+
+  FixedPoint digits = fp_create(precision);
+  FixedPointAccumulator sum(digits.size(), 0);
+
+  // Machin's formula: Pi = 16 * arctan(1/5) - 4 * arctan(1/239)
+  // arctan(1/5) needs about log(239) / log(5) = 3.4 times as many terms, hence the progress split
+  census_begin_phase("series");
+  if (!arctan_inverse_fixed_point(sum, 16, 5, false, 0.0, 0.77) ||
+      !arctan_inverse_fixed_point(sum, 4, 239, true, 0.77, 0.23))
+  {
+    return string();
+  }
+
+  report_calculation_progress(1.0);
+  fp_normalize(digits, sum);
+  return fp_to_decimal(digits, precision);
+}
+
 /**
  * Calculates Pi using numerical integration based on the rectangle rule (Riemann sum),
- * optimized with double precision inside the loop for speed, while periodically converting
- * results to GMP for enhanced precision. This method approximates Pi by summing small
- * areas under the curve and multiplying by 4. Although GMP can handle high precision,
- * the accuracy of this method is limited by numerical integration's inherent approximation
- * errors, which can accumulate. The accuracy typically reaches about 15-17 decimal places
- * depending on the chosen values for 'a', 'dx', and 'batch_size', representing a trade-off
- * between performance and accuracy.
+ * accumulated entirely in hardware double precision with Neumaier compensated summation.
+ * The running sum and a second double that collects the rounding error of every addition
+ * together behave like a double-double accumulator, so the tens of millions of small
+ * areas no longer lose their low bits, and GMP is only touched once at the end.
+ * This method approximates Pi by summing small areas under the curve and multiplying by 4.
+ * Although GMP can handle high precision, the accuracy of this method is limited by
+ * numerical integration's inherent approximation errors and by the rounding of each area
+ * in double precision. With the Euler-Maclaurin end correction the accuracy typically
+ * reaches about 18 decimal places depending on the chosen values for 'a' and 'dx'.
  * @return The calculated value of Pi using numerical integration
  */
 mpf_class calculate_pi_numerical_integration()
@@ -103,37 +276,42 @@ mpf_class calculate_pi_numerical_integration()
   double a2 = a * a;  // Precompute a^2 for efficiency
   double dx = 1.00;  // Initial small step size for integration
 
-  const int batch_size = 10000;  // Number of iterations per batch
-  mpf_class sum_gmp = 0.0;  // GMP accumulator for final precise result
-  double batch_sum = 0.0;  // Temporary double accumulator for each batch
-
-  int batch_count = 0;  // Counter to track iterations in the current batch
+  double sum = 0.0;  // Running sum of the areas (high part)
+  double compensation = 0.0;  // Accumulated rounding error of the additions (low part)
 
   // Loop through intervals for area approximation with adaptive step size
   for (double x = dx; x <= a - dx; x += dx)
   {
     double x2 = x * x;  // Compute x^2
-    batch_sum += (1.0 / (a2 + x2)) * dx;  // Accumulate area
+    double area = (1.0 / (a2 + x2)) * dx;  // Area of the current rectangle
 
-    // Every batch_size iterations, convert the batch_sum to GMP and reset batch_sum
-    if (++batch_count == batch_size)
+    // Neumaier step: add the area and recover exactly what the addition rounded away
+    double new_sum = sum + area;
+    if (fabs(sum) >= fabs(area))
+    {
+      compensation += (sum - new_sum) + area;
+    }
+    else
     {
-      sum_gmp += batch_sum;  // Accumulate in GMP
-      batch_sum = 0.0;  // Reset batch sum for the next batch
-      batch_count = 0;  // Reset counter
+      compensation += (area - new_sum) + sum;
     }
+    sum = new_sum;
   }
 
-  // Add any remaining sum from the last batch, if present
-  if (batch_sum != 0.0)
-  {
-    sum_gmp += batch_sum;
-  }
+  // Combine the high and low parts in GMP, where their sum is exact
+  mpf_class sum_gmp = sum;
+  sum_gmp += compensation;
 
   // Approximate the remaining area using the midpoint correction and add to GMP
   mpf_class remaining = (mpf_class(1.0) / a2 + mpf_class(1.0) / (2 * a2)) / 2.0 * dx;
   sum_gmp += remaining;
 
+  // With the rounding error gone, the trapezoid rule's own error (dx^2 / 12) * (f'(0) - f'(a))
+  // dominates; for f(x) = 1 / (a^2 + x^2) that is dx^2 / (24 * a^3), so add it back (Euler-Maclaurin)
+  mpf_class end_correction = mpf_class(dx) * dx / 24;
+  end_correction /= mpf_class(a) * a * a;
+  sum_gmp += end_correction;
+
   // Multiply by 4 and 'a' to approximate Pi using GMP precision
   mpf_class a_gmp = a;
   return 4.0 * sum_gmp * a_gmp;
@@ -147,14 +325,16 @@ mpf_class calculate_pi_numerical_integration()
 mpf_class calculate_pi_ramanujan()
 {
   mpf_class sum = 0.0;  // Initialize the sum to accumulate series terms
-  mpf_class factor = 2 * sqrt(mpf_class(2)) / 9801;  // Precompute the constant factor in Ramanujan's formula
 
   // NOTE: In the future iterations should not be hardcoded
   int iterations = 8;  // Number of iterations controls the precision of the result (precision vs. performance)
+  int loop = iteration_stats_loop("ramanujan");
 
   // Loop through each term in the series expansion
   for (int k = 0; k < iterations; ++k)
   {
+    uint64_t iteration_start = iteration_stats_now();
+
     // Calculate the numerator: (4k)! * (1103 + 26390k)
     mpf_class numerator = gmp_factorial(4 * k) * (1103 + 26390 * k);
 
@@ -174,10 +354,17 @@ mpf_class calculate_pi_ramanujan()
 
     // Add the current term (numerator / denominator) to the sum
     sum += numerator / denominator;
+    iteration_stats_record(loop, k, iteration_start);
   }
 
-  // Final step: Pi is calculated as 1 / (factor * sum)
-  return 1 / (factor * sum);
+  // Final step: Pi is calculated as 1 / ((2 * sqrt(2) / 9801) * sum), which is rearranged
+  // into 9801 / (2 * sqrt(2) * sum) so the tail needs one sqrt, one multiply and one division
+  mpf_class pi;
+  census_mpf_sqrt_ui(pi.get_mpf_t(), 2);  // sqrt(2) directly from the small integer, no temporary
+  census_mpf_mul(pi.get_mpf_t(), pi.get_mpf_t(), sum.get_mpf_t());  // sqrt(2) * sum
+  mpf_mul_2exp(pi.get_mpf_t(), pi.get_mpf_t(), 1);  // Multiply by 2 with a shift instead of a multiplication
+  census_mpf_ui_div(pi.get_mpf_t(), 9801, pi.get_mpf_t());  // Single full-precision division
+  return pi;
 }
 
 /**
@@ -187,17 +374,17 @@ mpf_class calculate_pi_ramanujan()
  */
 mpf_class calculate_pi_chudnovsky()
 {
-  // Constant term in the Chudnovsky formula: C = 426880 * sqrt(10005)
-  mpf_class C = 426880 * sqrt(mpf_class(10005));
-
   mpf_class sum = 0;  // Initialize the sum to accumulate series terms
 
   // NOTE: In the future iterations should not be hardcoded
   int iterations = 4;  // Number of iterations controls the precision of the result (precision vs. performance)
+  int loop = iteration_stats_loop("chudnovsky");
 
   // Loop through each term in the series expansion
   for (int k = 0; k < iterations; ++k)
   {
+    uint64_t iteration_start = iteration_stats_now();
+
     // Calculate the numerator: (6k)! * (13591409 + 545140134k)
     mpf_class numerator = gmp_factorial(6 * k) * (13591409 + 545140134 * k);
 
@@ -221,10 +408,16 @@ mpf_class calculate_pi_chudnovsky()
     {
       sum -= numerator / denominator;  // Subtract the current term from the sum
     }
+    iteration_stats_record(loop, k, iteration_start);
   }
 
-  // Final step: Pi is calculated as C / sum
-  return C / sum;
+  // Final step: Pi is calculated as C / sum, where C = 426880 * sqrt(10005)
+  // The constant is built in place from small integers so the tail is one sqrt and one division
+  mpf_class pi;
+  census_mpf_sqrt_ui(pi.get_mpf_t(), 10005);  // sqrt(10005)
+  census_mpf_mul_ui(pi.get_mpf_t(), pi.get_mpf_t(), 426880);  // C = 426880 * sqrt(10005)
+  census_mpf_div(pi.get_mpf_t(), pi.get_mpf_t(), sum.get_mpf_t());  // Pi = C / sum
+  return pi;
 }
 
 /**
@@ -242,10 +435,13 @@ mpf_class calculate_pi_gauss_legendre()
 
   // NOTE: In the future iterations should not be hardcoded
   int iterations = 5;  // Number of iterations controls the precision of the result (precision vs. performance)
+  int loop = iteration_stats_loop("gauss-legendre agm");
 
   // Loop through the iterative process to refine a, b, t, and p
   for (int i = 0; i < iterations; ++i)
   {
+    uint64_t iteration_start = iteration_stats_now();
+
     // Calculate the next value of a as the average of a and b
     mpf_class a_next = (a + b) / 2;
 
@@ -262,10 +458,99 @@ mpf_class calculate_pi_gauss_legendre()
     a = a_next;
     b = b_next;
     t = t_next;
+    iteration_stats_record(loop, i, iteration_start);
   }
 
   // Final step: Pi is calculated as (a + b)^2 / (4 * t)
-  return (a + b) * (a + b) / (4 * t);
+  // (a + b) is formed once and squared in place, and 4 * t is a shift, leaving a single division
+  mpf_class pi = a + b;
+  census_mpf_mul(pi.get_mpf_t(), pi.get_mpf_t(), pi.get_mpf_t());  // (a + b)^2
+  mpf_mul_2exp(t.get_mpf_t(), t.get_mpf_t(), 2);  // 4 * t
+  census_mpf_div(pi.get_mpf_t(), pi.get_mpf_t(), t.get_mpf_t());
+  return pi;
+}
+
+/**
+ * Calculates Pi using the Gauss-Legendre algorithm on scaled integers instead of mpf values
+ * a, b and t all stay between 0 and 1, so they are kept as mpz integers scaled by 2^bits:
+ * products are shifted back down by bits, sqrt(a * b) is an integer square root of the
+ * double-width product, and p = 2^i becomes a shift. Every variable and temporary is
+ * allocated once at full size and updated in place, so the iterations do no exponent
+ * handling and no reallocation. The iteration count follows from the precision: each
+ * step doubles the correct digits, and the loop stops once the next correction to t,
+ * 2^i * (a - b)^2 / 4, falls below one unit, after which further steps no longer change t
+ * @param precision The number of decimal places of Pi to calculate
+ * @return The calculated value of Pi, or 0 if the calculation was cancelled
+ */
+mpf_class calculate_pi_gauss_legendre_fixed_point(int precision)
+{
+  mp_bitcnt_t bits = static_cast<mp_bitcnt_t>(precision * 3.32193) + GAUSS_LEGENDRE_GUARD_BITS;
+  double expected_iterations = log2(static_cast<double>(bits)) + 1;  // For progress reports only
+
+  // One buffer per variable, sized for the largest value it will hold
+  mpz_class a, b, t, product, difference;
+  mpz_realloc2(a.get_mpz_t(), bits + GMP_NUMB_BITS);
+  mpz_realloc2(b.get_mpz_t(), bits + GMP_NUMB_BITS);
+  mpz_realloc2(t.get_mpz_t(), bits + GMP_NUMB_BITS);
+  mpz_realloc2(product.get_mpz_t(), 2 * bits + GMP_NUMB_BITS);
+  mpz_realloc2(difference.get_mpz_t(), 2 * bits + GMP_NUMB_BITS);
+
+  // a = 1, b = 1 / sqrt(2) = sqrt(2^(2 bits - 1)) / 2^bits, t = 1 / 4
+  census_begin_phase("setup");
+  mpz_set_ui(a.get_mpz_t(), 1);
+  mpz_mul_2exp(a.get_mpz_t(), a.get_mpz_t(), bits);
+  mpz_set_ui(product.get_mpz_t(), 1);
+  mpz_mul_2exp(product.get_mpz_t(), product.get_mpz_t(), 2 * bits - 1);
+  census_mpz_sqrt(b.get_mpz_t(), product.get_mpz_t());
+  mpz_fdiv_q_2exp(t.get_mpz_t(), a.get_mpz_t(), 2);
+
+  census_begin_phase("agm");
+  int loop = iteration_stats_loop("fixed-point gauss-legendre agm");
+  for (unsigned long i = 0; ; ++i)
+  {
+    uint64_t iteration_start = iteration_stats_now();
+
+    // Converged once the next correction is below one unit: with |a - b| < 2^s, the term
+    // (a - b)^2 * 2^(i - 2) at scale 2^(2 bits) is below 2^(2s + i - 2 - bits)
+    census_mpz_sub(difference.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+    if (2 * mpz_sizeinbase(difference.get_mpz_t(), 2) + i <= bits + 2)
+    {
+      break;
+    }
+
+    // b_next = sqrt(a * b): the double-width product's integer square root is back at scale 2^bits
+    parallel_mpz_mul(product.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+    census_mpz_sqrt(b.get_mpz_t(), product.get_mpz_t());
+
+    // a_next = (a + b) / 2 = a - (a - b) / 2
+    mpz_fdiv_q_2exp(product.get_mpz_t(), difference.get_mpz_t(), 1);
+    census_mpz_sub(a.get_mpz_t(), a.get_mpz_t(), product.get_mpz_t());
+
+    // t -= 2^i * (a - a_next)^2 = (a - b)^2 * 2^(i - 2), shifted back down from scale 2^(2 bits)
+    parallel_mpz_mul(product.get_mpz_t(), difference.get_mpz_t(), difference.get_mpz_t());
+    mpz_fdiv_q_2exp(product.get_mpz_t(), product.get_mpz_t(), bits + 2 - i);
+    census_mpz_sub(t.get_mpz_t(), t.get_mpz_t(), product.get_mpz_t());
+
+    iteration_stats_record(loop, i, iteration_start);
+    report_calculation_progress(min((i + 1) / expected_iterations, 1.0));
+    if (calculation_cancelled())
+    {
+      return mpf_class(0);
+    }
+  }
+
+  // Pi = (a + b)^2 / (4 * t): the square is at scale 2^(2 bits), so dividing by t leaves 2^bits
+  census_begin_phase("final");
+  census_mpz_add(difference.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+  parallel_mpz_mul(product.get_mpz_t(), difference.get_mpz_t(), difference.get_mpz_t());
+  parallel_mpz_tdiv_q(product.get_mpz_t(), product.get_mpz_t(), t.get_mpz_t());
+  mpz_fdiv_q_2exp(product.get_mpz_t(), product.get_mpz_t(), 2);
+
+  // Convert the fixed-point integer back to a floating-point value
+  mpf_class pi;
+  mpf_set_z(pi.get_mpf_t(), product.get_mpz_t());
+  mpf_div_2exp(pi.get_mpf_t(), pi.get_mpf_t(), bits);
+  return pi;
 }
 
 /**
@@ -316,10 +601,9 @@ mpf_class calculate_pi_spigot(int precision)
       pi += (predigit + 1) * multiplier;  // Adjust Pi with the corrected digit
       multiplier /= ten;  // Move the decimal place to the next position
 
-      // Set any earlier 9's to zero in Pi
+      // Set any earlier 9's to zero in Pi (the carry turned them into 0's, so only the place value moves)
       for (int k = 0; k < nines; ++k)
       {
-        pi += 9 * multiplier;  // Add 9 at the appropriate place value
         multiplier /= ten;  // Move the decimal place to the next position
       }
 
@@ -346,6 +630,7 @@ mpf_class calculate_pi_spigot(int precision)
 
   // Final step: Add the last digit and ensure the last one isn't missed
   pi += predigit * multiplier;
+  multiplier /= ten;  // Trailing 9's go after the last digit, not on top of it
 
   // If there were trailing 9's that were skipped, handle them here
   if (nines > 0)
@@ -393,86 +678,4 @@ mpf_class calculate_pi_bbp()
   return pi;  // Return the calculated value of Pi
 }
 
-/**
- * Times the Pi calculation and prints both the calculated Pi and the time taken
- * This function measures the time for Pi calculation and compares it to the known value of Pi
- * @param method The method to use for Pi calculation
- * @param precision The number of decimal places for the Pi calculation
- */
-void calculate_and_display_pi(int method, int precision)
-{
-  // Clear the screen before displaying the results
-  cout << "\x1b[2J";  // ANSI escape code to clear the screen
-
-  // Display the selected precision level
-  cout << "Precision level set to: " << precision << " decimal place(s)" << endl;
-
-  struct timeval start_time, end_time;  // To measure elapsed time
-  mpf_class pi;  // Variable to hold the calculated value of Pi
-
-  // Start the timer to measure calculation duration
-  gettimeofday(&start_time, nullptr);
-
-  // Determine the calculation method based on user selection and calculate Pi
-  switch (method)
-  {
-    case 0:
-      cout << "Calculating Pi using Numerical Integration Method..." << endl;
-      pi = calculate_pi_numerical_integration();
-      break;
-    case 1:
-      cout << "Calculating Pi using Machin's Formula Method..." << endl;
-      pi = calculate_pi_machin();
-      break;
-    case 2:
-      cout << "Calculating Pi using Ramanujan's First Series..." << endl;
-      pi = calculate_pi_ramanujan();
-      break;
-    case 3:
-      cout << "Calculating Pi using Chudnovsky's Algorithm..." << endl;
-      pi = calculate_pi_chudnovsky();
-      break;
-    case 4:
-      cout << "Calculating Pi using Gauss-Legendre Algorithm..." << endl;
-      pi = calculate_pi_gauss_legendre();
-      break;
-    case 5:
-      cout << "Calculating Pi using Spigot Algorithm..." << endl;
-      pi = calculate_pi_spigot(precision);
-      break;
-    case 6:
-      cout << "Calculating Pi using Bailey-Borwein-Plouffe (BBP) formula..." << endl;
-      pi = calculate_pi_bbp();
-      break;
-    default:
-      cout << "Invalid method selection." << endl;
-      return;
-    }
-
-  // Stop the timer now that calculation is complete
-  gettimeofday(&end_time, nullptr);
-
-  // Calculate the elapsed time in milliseconds
-  double time_taken = (end_time.tv_sec - start_time.tv_sec) * 1000.0 + (end_time.tv_usec - start_time.tv_usec) / 1000.0;
-
-  // Indicate that the Pi calculation has completed
-  cout << "\nPi Calculation Complete!" << endl;
-
-  // Handle unrealistic time values (negative or zero), which may occur in emulation
-  if (time_taken <= 0)
-  {
-    cout << "Time taken: unknown (possibly due to emulation)" << endl;
-  }
-  else
-  {
-    cout << "Time taken: " << time_taken << " millisecond(s)" << endl;
-  }
-
-  // Call function to display and compare calculated results to expected results
-  compare_pi_accuracy(pi, precision);
-
-  // Call the utility function to handle returning to the menu
-  wait_for_user_input_to_return();
-}
-
 // EOF
@@ -20,15 +20,28 @@
 #define PI_CALCULATION_HPP
 
 #include <gmpxx.h>
+#include <string>
+
+// Optional callbacks that long-running engines use to report progress and check for cancellation
+struct CalculationHooks{
+  void (*progress)(double fraction, void *user_data);  // Called with the completed fraction (0 to 1)
+  bool (*cancel)(void *user_data);  // Returns true to stop the calculation early
+  void *user_data;  // Passed back to both callbacks
+};
+
+void set_calculation_hooks(const CalculationHooks *hooks);
+void report_calculation_progress(double fraction);
+bool calculation_cancelled();
 
 mpf_class calculate_pi_machin();
+std::string calculate_pi_machin_fixed_point(int precision);
 mpf_class calculate_pi_numerical_integration();
 mpf_class calculate_pi_ramanujan();
 mpf_class calculate_pi_chudnovsky();
 mpf_class calculate_pi_gauss_legendre();
+mpf_class calculate_pi_gauss_legendre_fixed_point(int precision);
 mpf_class calculate_pi_spigot(int precision);
 mpf_class calculate_pi_bbp();
-void calculate_and_display_pi(int method, int precision);
 
 #endif
 
@@ -0,0 +1,247 @@
+// pi_display.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// The interactive calculation screen: runs the selected engine, shows and checks the
+// result and saves it. Kept apart from the engines so they build without the UI
+
+#include "pi_display.hpp"
+#include "pi_calculation.hpp"
+#include "binary_splitting.hpp"
+#include "utility.hpp"
+#include "input.hpp"
+#include "output_writer.hpp"
+#include "census.hpp"
+#include "profiler.hpp"
+#include "iteration_stats.hpp"
+#include "digit_cache.hpp"
+#include <gmpxx.h>
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+/**
+ * Saves the calculated digits to the SD card and appends a line to the run log
+ * Both files go through the buffered background writer, so the SD card never blocks the caller
+ * Nothing is saved if no SD card is mounted
+ * @param method The method used for the calculation
+ * @param precision The number of decimal places calculated
+ * @param digits The calculated Pi value as a decimal string
+ * @param time_taken The calculation time in milliseconds
+ */
+static void save_pi_result(int method, int precision, const string &digits, double time_taken)
+{
+  string digits_path = string(output_storage_root()) + "/pi_digits.txt";
+  OutputWriter *writer = output_writer_open(digits_path.c_str(), false, digits.size() + 1);
+  if (!writer)
+  {
+    return;  // No SD card (or it could not be written), so skip saving
+  }
+
+  output_writer_write(writer, digits.data(), digits.size());
+  output_writer_write(writer, "\n", 1);
+
+  OutputWriterStats stats;
+  if (output_writer_close(writer, &stats))
+  {
+    cout << "Saved " << stats.bytes_written << " byte(s) to " << digits_path
+         << " (" << stats.megabytes_per_second << " MB/s)" << endl;
+  }
+  else
+  {
+    cout << "Failed to save the digits to " << digits_path << endl;
+  }
+
+  // Append a one-line summary of this run to the log
+  string log_path = string(output_storage_root()) + "/wpcpp.log";
+  char line[128];
+  int length = snprintf(line, sizeof(line), "method=%d precision=%d time_ms=%.3f\n", method, precision, time_taken);
+  writer = output_writer_open(log_path.c_str(), true, length);
+  if (writer)
+  {
+    output_writer_write(writer, line, length);
+    output_writer_close(writer, nullptr);
+  }
+}
+
+/**
+ * Checks whether a method is one of the arbitrary-precision engines (7 and up), which are
+ * exact to the requested precision, so their results can be cached and served from the cache
+ * @param method The method
+ * @return True for an exact engine
+ */
+static bool is_exact_method(int method)
+{
+  return method >= 7 && method <= 10;
+}
+
+/**
+ * Times the Pi calculation and prints both the calculated Pi and the time taken
+ * This function measures the time for Pi calculation and compares it to the known value of Pi
+ * @param method The method to use for Pi calculation
+ * @param precision The number of decimal places for the Pi calculation
+ */
+void calculate_and_display_pi(int method, int precision)
+{
+  // Clear the screen before displaying the results
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+
+  // Display the selected precision level
+  cout << "Precision level set to: " << precision << " decimal place(s)" << endl;
+
+  struct timeval start_time, end_time;  // To measure elapsed time
+  mpf_class pi;  // Variable to hold the calculated value of Pi
+  string pi_digits;  // Decimal result of engines that produce digits directly (empty otherwise)
+
+  // Start the timer to measure calculation duration (and a fresh operation census, profile
+  // or set of iteration histograms, in CENSUS=1, PROFILE=1 or ITERATION_STATS=1 builds)
+  census_reset();
+  iteration_stats_reset();
+  profiler_start();
+  gettimeofday(&start_time, nullptr);
+
+  // The exact engines answer from the digit cache when it covers the request; otherwise
+  // determine the calculation method based on user selection and calculate Pi
+  bool from_cache = is_exact_method(method) && digit_cache_lookup(precision, pi_digits);
+  if (from_cache)
+  {
+    cout << "Reading Pi from the digit cache..." << endl;
+  }
+  else
+  {
+    switch (method)
+    {
+      case 0:
+        cout << "Calculating Pi using Numerical Integration Method..." << endl;
+        pi = calculate_pi_numerical_integration();
+        break;
+      case 1:
+        cout << "Calculating Pi using Machin's Formula Method..." << endl;
+        pi = calculate_pi_machin();
+        break;
+      case 2:
+        cout << "Calculating Pi using Ramanujan's First Series..." << endl;
+        pi = calculate_pi_ramanujan();
+        break;
+      case 3:
+        cout << "Calculating Pi using Chudnovsky's Algorithm..." << endl;
+        pi = calculate_pi_chudnovsky();
+        break;
+      case 4:
+        cout << "Calculating Pi using Gauss-Legendre Algorithm..." << endl;
+        pi = calculate_pi_gauss_legendre();
+        break;
+      case 5:
+        cout << "Calculating Pi using Spigot Algorithm..." << endl;
+        pi = calculate_pi_spigot(precision);
+        break;
+      case 6:
+        cout << "Calculating Pi using Bailey-Borwein-Plouffe (BBP) formula..." << endl;
+        pi = calculate_pi_bbp();
+        break;
+      case 7:
+        cout << "Calculating Pi using Machin's Formula (Base 10^9 Fixed-Point)..." << endl;
+        pi_digits = calculate_pi_machin_fixed_point(precision);
+        break;
+      case 8:
+        cout << "Calculating Pi using Chudnovsky's Algorithm (Binary Splitting)..." << endl;
+        pi = calculate_pi_chudnovsky_binary_splitting(precision);
+        break;
+      case 9:
+        cout << "Calculating Pi using the BBP Formula (Binary Splitting)..." << endl;
+        pi = calculate_pi_bbp_binary_splitting(precision);
+        break;
+      case 10:
+        cout << "Calculating Pi using Gauss-Legendre Algorithm (Fixed-Point)..." << endl;
+        pi = calculate_pi_gauss_legendre_fixed_point(precision);
+        break;
+      default:
+        cout << "Invalid method selection." << endl;
+        return;
+    }
+  }
+
+  // Stop the timer (and the profiler) now that calculation is complete
+  gettimeofday(&end_time, nullptr);
+  profiler_stop();
+
+  // Calculate the elapsed time in milliseconds
+  double time_taken = (end_time.tv_sec - start_time.tv_sec) * 1000.0 + (end_time.tv_usec - start_time.tv_usec) / 1000.0;
+
+  // Indicate that the Pi calculation has completed
+  cout << "\nPi Calculation Complete!" << endl;
+
+  // Handle unrealistic time values (negative or zero), which may occur in emulation
+  if (time_taken <= 0)
+  {
+    cout << "Time taken: unknown (possibly due to emulation)" << endl;
+  }
+  else
+  {
+    cout << "Time taken: " << time_taken << " millisecond(s)" << endl;
+  }
+
+  // Show what the engine did, bucketed by operand size (only in CENSUS=1 builds)
+  census_print();
+
+  // Show the per-iteration latencies of the loops that ran (only in ITERATION_STATS=1 builds)
+  iteration_stats_print();
+
+  // Show where the time went, per function (only in PROFILE=1 builds)
+  char profile_label[64];
+  snprintf(profile_label, sizeof(profile_label), "method %d at %d digit(s)", method, precision);
+  profiler_report(profile_label);
+
+  // Convert binary results once; the same digits are compared, saved and cached
+  bool binary_result = pi_digits.empty();
+  if (binary_result)
+  {
+    if (pi <= 0)
+    {
+      cout << "Invalid input: Pi cannot be less than or equal to zero." << endl;
+      wait_for_user_input_to_return();
+      return;
+    }
+    pi_digits = format_pi(pi, precision);
+  }
+
+  // Call function to display and compare calculated results to expected results
+  bool correct = compare_pi_digits(pi_digits.c_str(), precision);
+
+  // Beyond the built-in places, binary results are also spot checked by BBP digit extraction
+  if (correct && binary_result && precision > PI_DIGITS)
+  {
+    correct = spot_check_pi(pi, precision);
+  }
+
+  // Save the digits and a log entry to the SD card
+  save_pi_result(method, precision, pi_digits, time_taken);
+
+  // Digits from an exact engine that passed these checks can answer later requests
+  if (correct && !from_cache && is_exact_method(method))
+  {
+    digit_cache_store(method, pi_digits);
+  }
+
+  // Call the utility function to handle returning to the menu
+  wait_for_user_input_to_return();
+}
+
+// EOF
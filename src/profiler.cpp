@@ -0,0 +1,433 @@
+// profiler.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "profiler.hpp"
+
+#ifdef WPCPP_PROFILE
+
+#include "output_writer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef GEKKO
+#include <gccore.h>
+#else
+#include <dlfcn.h>
+#include <link.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+// Program counters recorded by the timer interrupt; only the interrupt writes while running
+static uintptr_t samples[PROFILE_MAX_SAMPLES];
+static volatile size_t num_samples = 0;
+static volatile unsigned long dropped_samples = 0;
+
+/**
+ * Records one sample (called from the timer interrupt or signal handler)
+ * @param pc The interrupted program counter
+ */
+static inline void record_sample(uintptr_t pc)
+{
+  if (num_samples < PROFILE_MAX_SAMPLES)
+  {
+    samples[num_samples] = pc;
+    num_samples = num_samples + 1;
+  }
+  else
+  {
+    dropped_samples = dropped_samples + 1;
+  }
+}
+
+#ifdef GEKKO
+
+// libogc dispatches exceptions through this table; the decrementer entry drives its alarms
+extern "C" void (*_exceptionhandlertable[])(frame_context *);
+
+static void (*previous_decrementer_handler)(frame_context *) = nullptr;  // Handler chained to
+static syswd_t sample_alarm;  // Keeps the decrementer firing at the sampling rate
+
+/**
+ * Decrementer exception handler: samples the interrupted address, then lets libogc
+ * handle the exception as usual (alarms and thread time slices depend on it)
+ * @param context The interrupted context
+ */
+static void sample_decrementer(frame_context *context)
+{
+  record_sample(context->SRR0);
+  previous_decrementer_handler(context);
+}
+
+/**
+ * Periodic alarm callback; it does nothing itself, it only makes the decrementer fire
+ * @param alarm The alarm
+ * @param user_data Unused
+ */
+static void sample_alarm_tick(syswd_t alarm, void *user_data)
+{
+}
+
+/**
+ * Starts sampling, clearing the samples of the previous run
+ */
+void profiler_start()
+{
+  num_samples = 0;
+  dropped_samples = 0;
+
+  u32 level = IRQ_Disable();
+  previous_decrementer_handler = _exceptionhandlertable[EX_DEC];
+  _exceptionhandlertable[EX_DEC] = sample_decrementer;
+  IRQ_Restore(level);
+
+  struct timespec interval = {0, PROFILE_INTERVAL_US * 1000};
+  SYS_CreateAlarm(&sample_alarm);
+  SYS_SetPeriodicAlarm(sample_alarm, &interval, &interval, sample_alarm_tick, nullptr);
+}
+
+/**
+ * Stops sampling and restores the original decrementer handler
+ */
+void profiler_stop()
+{
+  SYS_RemoveAlarm(sample_alarm);
+
+  u32 level = IRQ_Disable();
+  _exceptionhandlertable[EX_DEC] = previous_decrementer_handler;
+  IRQ_Restore(level);
+}
+
+/**
+ * Returns the difference between run-time and link-time addresses
+ * @return Always 0, since the Wii executable is loaded at its link address
+ */
+static uintptr_t load_bias()
+{
+  return 0;
+}
+
+/**
+ * Names an address outside the linker map
+ * @param pc The address
+ * @return An empty string, since everything is statically linked into the map on the Wii
+ */
+static string describe_unmapped(uintptr_t pc)
+{
+  return "";
+}
+
+#else
+
+static uintptr_t executable_start = 0;  // Run-time range of the executable's code
+static uintptr_t executable_end = 0;
+static uintptr_t executable_bias = 0;  // Run-time minus link-time addresses (nonzero for PIE)
+
+/**
+ * SIGPROF handler: samples the interrupted address
+ * @param signal_number Unused
+ * @param info Unused
+ * @param context The interrupted user context
+ */
+static void sample_signal(int signal_number, siginfo_t *info, void *context)
+{
+  ucontext_t *user_context = static_cast<ucontext_t *>(context);
+#if defined(__x86_64__)
+  record_sample(user_context->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__i386__)
+  record_sample(user_context->uc_mcontext.gregs[REG_EIP]);
+#elif defined(__aarch64__)
+  record_sample(user_context->uc_mcontext.pc);
+#else
+  record_sample(0);  // Unknown host; samples still count toward the total
+#endif
+}
+
+/**
+ * Finds the executable's code segment (the first object dl_iterate_phdr reports)
+ * @param info The object's program headers
+ * @param size Unused
+ * @param data Unused
+ * @return 1 to stop after the executable
+ */
+static int find_executable(struct dl_phdr_info *info, size_t size, void *data)
+{
+  executable_bias = info->dlpi_addr;
+  for (int i = 0; i < info->dlpi_phnum; ++i)
+  {
+    const ElfW(Phdr) &header = info->dlpi_phdr[i];
+    if (header.p_type == PT_LOAD && (header.p_flags & PF_X))
+    {
+      executable_start = info->dlpi_addr + header.p_vaddr;
+      executable_end = executable_start + header.p_memsz;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Starts sampling, clearing the samples of the previous run
+ */
+void profiler_start()
+{
+  num_samples = 0;
+  dropped_samples = 0;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = sample_signal;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, nullptr);
+
+  struct itimerval timer = {{0, PROFILE_INTERVAL_US}, {0, PROFILE_INTERVAL_US}};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+/**
+ * Stops sampling
+ */
+void profiler_stop()
+{
+  struct itimerval timer = {{0, 0}, {0, 0}};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  signal(SIGPROF, SIG_IGN);
+}
+
+/**
+ * Returns the difference between run-time and link-time addresses
+ * @return The executable's load bias
+ */
+static uintptr_t load_bias()
+{
+  dl_iterate_phdr(find_executable, nullptr);
+  return executable_bias;
+}
+
+/**
+ * Names an address outside the linker map, such as one in a shared library
+ * @param pc The address
+ * @return "symbol [library]" (or just the library), or an empty string if the address is in the executable
+ */
+static string describe_unmapped(uintptr_t pc)
+{
+  if (pc >= executable_start && pc < executable_end)
+  {
+    return "";
+  }
+
+  Dl_info info;
+  if (!dladdr(reinterpret_cast<void *>(pc), &info) || !info.dli_fname)
+  {
+    return "[unknown]";
+  }
+
+  const char *library = strrchr(info.dli_fname, '/');
+  library = library ? library + 1 : info.dli_fname;
+  return info.dli_sname ? string(info.dli_sname) + " [" + library + "]" : string("[") + library + "]";
+}
+
+#endif
+
+// A symbol from the linker map: its link-time address and where its line starts in the file
+struct MapSymbol{
+  uintptr_t address;
+  long offset;
+};
+
+/**
+ * Parses a symbol line of a GNU ld map ("  0x<address>  <name>")
+ * Section lines ("0x<address> 0x<size> <object>") and assignments are rejected
+ * @param line The line
+ * @param address Receives the symbol's address
+ * @return The start of the symbol's name, or nullptr if the line isn't a symbol
+ */
+static const char *parse_map_line(const char *line, uintptr_t *address)
+{
+  const char *p = line;
+  while (*p == ' ')
+  {
+    ++p;
+  }
+  if (p == line || strncmp(p, "0x", 2) != 0)
+  {
+    return nullptr;
+  }
+
+  char *end;
+  *address = static_cast<uintptr_t>(strtoull(p, &end, 16));
+  if (end == p || *end != ' ' || *address == 0)
+  {
+    return nullptr;
+  }
+
+  p = end;
+  while (*p == ' ')
+  {
+    ++p;
+  }
+  if (*p == '\0' || *p == '\n' || strncmp(p, "0x", 2) == 0 || strncmp(p, "PROVIDE", 7) == 0 || strstr(p, " = "))
+  {
+    return nullptr;
+  }
+  return p;
+}
+
+/**
+ * Reads the name of a symbol found earlier in the map
+ * @param map The open map file
+ * @param symbol The symbol
+ * @return The name
+ */
+static string read_symbol_name(FILE *map, const MapSymbol &symbol)
+{
+  char line[4096];
+  uintptr_t address;
+  fseek(map, symbol.offset, SEEK_SET);
+  const char *name = fgets(line, sizeof(line), map) ? parse_map_line(line, &address) : nullptr;
+  if (!name)
+  {
+    return "?";
+  }
+
+  string result = name;
+  while (!result.empty() && (result.back() == '\n' || result.back() == '\r' || result.back() == ' '))
+  {
+    result.pop_back();
+  }
+  return result;
+}
+
+/**
+ * Writes a flat profile of the last run: samples per function, most frequent first
+ * Functions are named from the linker map next to the program (only addresses and
+ * file offsets are kept while matching, so large maps fit in memory); without the
+ * map, samples are grouped into 256-byte address ranges instead
+ * @param label What was profiled (shown in the report)
+ */
+void profiler_report(const char *label)
+{
+  size_t total = num_samples;
+  sort(samples, samples + total);
+
+  string map_path = string(output_storage_root()) + "/" + WPCPP_MAP_NAME;
+  FILE *map = fopen(map_path.c_str(), "r");
+  bool have_map = (map != nullptr);
+  vector<MapSymbol> symbols;
+  if (have_map)
+  {
+    char line[4096];
+    long offset = ftell(map);
+    while (fgets(line, sizeof(line), map))
+    {
+      uintptr_t address;
+      if (parse_map_line(line, &address))
+      {
+        symbols.push_back({address, offset});
+      }
+      offset = ftell(map);
+    }
+    sort(symbols.begin(), symbols.end(), [](const MapSymbol &a, const MapSymbol &b) { return a.address < b.address; });
+  }
+
+  // Count samples per symbol (or per library symbol / address range)
+  uintptr_t bias = load_bias();
+  std::map<size_t, unsigned long> symbol_counts;
+  std::map<string, unsigned long> other_counts;
+  for (size_t i = 0; i < total; ++i)
+  {
+    uintptr_t pc = samples[i];
+    string unmapped = describe_unmapped(pc);
+    if (!unmapped.empty())
+    {
+      other_counts[unmapped]++;
+      continue;
+    }
+
+    uintptr_t address = pc - bias;
+    auto next = upper_bound(symbols.begin(), symbols.end(), address, [](uintptr_t a, const MapSymbol &s) { return a < s.address; });
+    if (next == symbols.begin())
+    {
+      char range[32];
+      snprintf(range, sizeof(range), "0x%08lx", static_cast<unsigned long>(address & ~static_cast<uintptr_t>(0xFF)));
+      other_counts[range]++;
+    }
+    else
+    {
+      symbol_counts[(next - symbols.begin()) - 1]++;
+    }
+  }
+
+  vector<pair<unsigned long, string>> entries;
+  for (const auto &entry : symbol_counts)
+  {
+    entries.push_back({entry.second, read_symbol_name(map, symbols[entry.first])});
+  }
+  for (const auto &entry : other_counts)
+  {
+    entries.push_back({entry.second, entry.first});
+  }
+  sort(entries.begin(), entries.end(), [](const pair<unsigned long, string> &a, const pair<unsigned long, string> &b) { return a.first > b.first; });
+
+  if (have_map)
+  {
+    fclose(map);
+  }
+
+  // Full profile to the SD card, top entries on screen
+  char header[256];
+  snprintf(header, sizeof(header), "Profile of %s: %lu sample(s) every %d us, %lu dropped%s\n", label,
+           static_cast<unsigned long>(total), PROFILE_INTERVAL_US, static_cast<unsigned long>(dropped_samples),
+           have_map ? "" : " (no linker map, showing address ranges)");
+  string report = header;
+  cout << "\n" << header;
+
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    char row[64];
+    snprintf(row, sizeof(row), "  %5.1f%% %7lu  ", 100.0 * entries[i].first / total, entries[i].first);
+    report += row + entries[i].second + "\n";
+    if (i < PROFILE_REPORT_LINES)
+    {
+      cout << row << entries[i].second.substr(0, 50) << endl;
+    }
+  }
+
+  string path = string(output_storage_root()) + "/wpcpp_profile.txt";
+  OutputWriter *writer = output_writer_open(path.c_str(), true, report.size() + 1);
+  if (writer)
+  {
+    report += "\n";
+    output_writer_write(writer, report.data(), report.size());
+    output_writer_close(writer, nullptr);
+  }
+}
+
+#endif
+
+// EOF
@@ -0,0 +1,51 @@
+// profiler.hpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Sampling profiler: records the interrupted program counter on a periodic timer
+// (the decrementer on Broadway, SIGPROF on hosts) and writes a flat per-function
+// profile, symbolized with the linker map. Enabled by building with PROFILE=1
+// (which defines WPCPP_PROFILE); otherwise the calls below compile to nothing
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#define PROFILE_INTERVAL_US 1000  // Time between samples
+#define PROFILE_MAX_SAMPLES 65536  // Samples kept per run (later ones are counted as dropped)
+#define PROFILE_REPORT_LINES 10  // Functions shown on screen (the file lists all of them)
+
+#ifndef WPCPP_MAP_NAME
+#define WPCPP_MAP_NAME "WPCPP.elf.map"  // Linker map, copied next to the program
+#endif
+
+#ifdef WPCPP_PROFILE
+
+void profiler_start();
+void profiler_stop();
+void profiler_report(const char *label);
+
+#else
+
+inline void profiler_start() {}
+inline void profiler_stop() {}
+inline void profiler_report(const char *) {}
+
+#endif
+
+#endif
+
+// EOF
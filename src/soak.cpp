@@ -0,0 +1,216 @@
+// soak.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "soak.hpp"
+#include "heap_stats.hpp"
+#include "output_writer.hpp"
+#include "input.hpp"
+#include "wpcpp.h"
+#include <gccore.h>
+#include <wiiuse/wpad.h>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define TREND_MIN_RUNS 8  // Runs needed before a trend is judged
+#define TREND_HORIZON_RUNS 1000  // A trend is flagged if it would cost this much over this many runs...
+#define TREND_LIMIT_FRACTION 0.10  // ...relative to the first sample (10%)
+
+// One step of the soak cycle: an engine and the precision to run it at
+struct SoakStep{
+  wpcpp_method method;
+  size_t digits;
+};
+
+// Every engine at its usable precision, plus the scalable engines at growing sizes
+// so allocations of many different sizes interleave on the heap
+static const SoakStep soak_cycle[] = {
+  {WPCPP_METHOD_NUMERICAL_INTEGRATION, 15},
+  {WPCPP_METHOD_MACHIN, 50},
+  {WPCPP_METHOD_RAMANUJAN, 50},
+  {WPCPP_METHOD_CHUDNOVSKY, 50},
+  {WPCPP_METHOD_GAUSS_LEGENDRE, 50},
+  {WPCPP_METHOD_SPIGOT, 50},
+  {WPCPP_METHOD_BBP, 50},
+  {WPCPP_METHOD_MACHIN_FIXED_POINT, 1000},
+  {WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING, 1000},
+  {WPCPP_METHOD_BBP_BINARY_SPLITTING, 1000},
+  {WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT, 1000},
+  {WPCPP_METHOD_MACHIN_FIXED_POINT, 10000},
+  {WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING, 100000},
+  {WPCPP_METHOD_BBP_BINARY_SPLITTING, 10000},
+  {WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT, 100000},
+  {WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING, 10000}
+};
+
+// Running least-squares fit of a metric against the run number
+struct Trend{
+  double n, sum_x, sum_y, sum_xy, sum_xx;
+};
+
+/**
+ * Adds a sample to a trend
+ * @param trend The trend to update
+ * @param x The run number
+ * @param y The metric value
+ */
+static void add_to_trend(Trend &trend, double x, double y)
+{
+  trend.n += 1;
+  trend.sum_x += x;
+  trend.sum_y += y;
+  trend.sum_xy += x * y;
+  trend.sum_xx += x * x;
+}
+
+/**
+ * Returns the fitted change of a metric per run
+ * @param trend The trend
+ * @return The least-squares slope, or 0 with fewer than two samples
+ */
+static double trend_slope(const Trend &trend)
+{
+  double denominator = trend.n * trend.sum_xx - trend.sum_x * trend.sum_x;
+  return (denominator != 0) ? (trend.n * trend.sum_xy - trend.sum_x * trend.sum_y) / denominator : 0.0;
+}
+
+/**
+ * Judges whether a trend would lose (or gain, for leaks) too much over the horizon
+ * @param trend The trend
+ * @param baseline The metric's first sample
+ * @param growing True if an increase is the problem (leaks), false if a decrease is (fragmentation)
+ * @return True if the trend should be flagged
+ */
+static bool trend_is_bad(const Trend &trend, double baseline, bool growing)
+{
+  if (trend.n < TREND_MIN_RUNS)
+  {
+    return false;
+  }
+  double projected = trend_slope(trend) * TREND_HORIZON_RUNS * (growing ? 1.0 : -1.0);
+  double limit = (baseline > 0 ? baseline : 1024.0 * 1024.0) * TREND_LIMIT_FRACTION;
+  return projected > limit;
+}
+
+/**
+ * Runs every engine at several precisions in a loop until a button is pressed,
+ * sampling free heap, largest free block and GMP live bytes after each run
+ * Fitted trends flag fragmentation (largest block shrinking) and leaks (free space or
+ * GMP bytes drifting), which tells whether long kiosk-style sessions will degrade
+ * Each sample is also appended to wpcpp_soak.log on the SD card
+ */
+void run_soak_test()
+{
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Soak Test: cycling all methods and precisions." << endl;
+  cout << "Hold any button to stop (checked between runs)." << endl;
+
+  string log_path = string(output_storage_root()) + "/wpcpp_soak.log";
+  OutputWriter *log = output_writer_open(log_path.c_str(), true);
+
+  // The largest block is measured by allocating, so say how coarse and intrusive that is
+  char note[160];
+  int note_length = snprintf(note, sizeof(note),
+                             "Largest: probed with malloc/free in %d KiB steps (probes may briefly grow the heap)\n",
+                             HEAP_PROBE_GRANULARITY / 1024);
+  cout << note;
+  if (log)
+  {
+    output_writer_write(log, note, note_length);
+  }
+
+  cout << endl << " Run  Method  Digits    Time(ms)  Free(KiB)  Largest(KiB)  GMP(KiB)" << endl;
+
+  HeapSample baseline = sample_heap();
+  Trend free_trend = {}, largest_trend = {}, gmp_trend = {};
+  unsigned long run = 0;
+  size_t cycle_length = sizeof(soak_cycle) / sizeof(soak_cycle[0]);
+
+  while (true)
+  {
+    const SoakStep &step = soak_cycle[run % cycle_length];
+    struct timeval start_time, end_time;
+
+    gettimeofday(&start_time, nullptr);
+    wpcpp_result *result = nullptr;
+    wpcpp_compute(step.method, step.digits, nullptr, &result);
+    wpcpp_release(result);
+    gettimeofday(&end_time, nullptr);
+
+    double time_taken = (end_time.tv_sec - start_time.tv_sec) * 1000.0 + (end_time.tv_usec - start_time.tv_usec) / 1000.0;
+
+    // Sample after the result is released, so anything left over is retained state
+    HeapSample sample = sample_heap();
+    add_to_trend(free_trend, run, sample.free_bytes);
+    add_to_trend(largest_trend, run, sample.largest_free_block);
+    add_to_trend(gmp_trend, run, sample.gmp_live_bytes);
+
+    char line[160];
+    int length = snprintf(line, sizeof(line), "%4lu  %6d  %6lu  %10.1f  %9lu  %12lu  %8lu\n",
+                          run, static_cast<int>(step.method), static_cast<unsigned long>(step.digits), time_taken,
+                          static_cast<unsigned long>(sample.free_bytes / 1024),
+                          static_cast<unsigned long>(sample.largest_free_block / 1024),
+                          static_cast<unsigned long>(sample.gmp_live_bytes / 1024));
+    cout << line;
+    if (log)
+    {
+      output_writer_write(log, line, length);
+    }
+
+    ++run;
+
+    // Stop once the user presses any button (checked between runs)
+    poll_inputs();
+    if (is_button_just_pressed(0xFFFFFFFF, 0xFFFFFFFF))
+    {
+      break;
+    }
+  }
+
+  // Summarize the fitted trends and flag the ones that would degrade a long session
+  bool fragmenting = trend_is_bad(largest_trend, baseline.largest_free_block, false);
+  bool shrinking = trend_is_bad(free_trend, baseline.free_bytes, false);
+  bool leaking = trend_is_bad(gmp_trend, 0, true);
+
+  char summary[320];
+  int length = snprintf(summary, sizeof(summary),
+                        "\nSoak summary after %lu run(s):\n"
+                        "Free heap trend:     %+.1f byte(s)/run%s\n"
+                        "Largest block trend: %+.1f byte(s)/run%s\n"
+                        "GMP live trend:      %+.1f byte(s)/run%s\n",
+                        run,
+                        trend_slope(free_trend), shrinking ? "  <-- possible leak" : "",
+                        trend_slope(largest_trend), fragmenting ? "  <-- fragmentation" : "",
+                        trend_slope(gmp_trend), leaking ? "  <-- GMP leak" : "");
+  cout << summary;
+  if (log)
+  {
+    output_writer_write(log, summary, length);
+    output_writer_close(log, nullptr);
+  }
+
+  if (!fragmenting && !shrinking && !leaking)
+  {
+    cout << (run < TREND_MIN_RUNS ? "Too few runs to judge trends." : "No degrading trends detected.") << endl;
+  }
+}
+
+// EOF
@@ -0,0 +1,370 @@
+// time_budget.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "time_budget.hpp"
+#include "pi_calculation.hpp"
+#include "binary_splitting.hpp"
+#include "heap_stats.hpp"
+#include "output_writer.hpp"
+#include "digit_cache.hpp"
+#include "utility.hpp"
+#include <gmpxx.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define BUDGET_SAFETY 0.8  // Aim for this fraction of the remaining time, leaving room for model error
+#define BUDGET_BLOCKS 4  // Segments of the binary splitting run; each completed one is a usable fallback
+#define BYTES_PER_DIGIT 16  // Conservative peak heap use per digit (engine, final division and conversion)
+#define SHOWN_DIGITS 50  // Digits shown at the start and end of the result
+
+// A result of one of the scalable engines: binary splitting yields a float, Machin yields text
+struct BudgetResult{
+  int digits;  // Certified decimal places (0 if there is no result)
+  double milliseconds;  // Time the run took
+  double tail_milliseconds;  // Part of it after the series completed (final steps, which cannot be cancelled)
+  mpf_class value;  // Binary splitting result
+  string text;  // Fixed-point Machin result ("3.14159...")
+};
+
+// Fitted cost model t(d) = t2 * (d / d2)^exponent from two calibration runs
+struct CostModel{
+  const char *name;
+  int calibration_digits[2];
+  double calibration_ms[2];
+  double exponent;
+  double tail_fraction;  // Share of a run spent after the series, measured on the larger calibration run
+};
+
+static struct timeval deadline;  // When the main run's series must stop, early enough for the final steps
+static struct timeval run_start;  // When the current engine run started
+static double series_end_ms;  // When the current run's series completed (negative until then)
+
+/**
+ * Returns the milliseconds elapsed since a start time
+ * @param start The start time
+ * @return The elapsed time in milliseconds
+ */
+static double elapsed_ms(const struct timeval &start)
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_usec - start.tv_usec) / 1000.0;
+}
+
+/**
+ * Returns a time shifted by a number of milliseconds
+ * @param time The time to shift
+ * @param milliseconds The shift (may be negative)
+ * @return The shifted time
+ */
+static struct timeval offset_time(const struct timeval &time, double milliseconds)
+{
+  long long microseconds = time.tv_sec * 1000000LL + time.tv_usec + static_cast<long long>(milliseconds * 1000.0);
+  struct timeval shifted;
+  shifted.tv_sec = static_cast<time_t>(microseconds / 1000000);
+  shifted.tv_usec = static_cast<suseconds_t>(microseconds % 1000000);
+  return shifted;
+}
+
+/**
+ * Progress hook that records when the series completes; both engines report 1.0 right
+ * before their final steps
+ * @param fraction The completed fraction of the calculation
+ * @param user_data Unused
+ */
+static void record_series_end(double fraction, void *user_data)
+{
+  if (fraction >= 1.0 && series_end_ms < 0)
+  {
+    series_end_ms = elapsed_ms(run_start);
+  }
+}
+
+/**
+ * Cancellation hook that stops the calculation once the deadline has passed
+ * @param user_data Unused
+ * @return True once the deadline has passed
+ */
+static bool deadline_passed(void *user_data)
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_usec >= deadline.tv_usec);
+}
+
+/**
+ * Keeps a result if it certifies more digits than the best one so far
+ * Assigning an mpf_class keeps the destination's precision, so it is matched first
+ * @param best The best result so far
+ * @param result The candidate result
+ */
+static void keep_if_better(BudgetResult &best, const BudgetResult &result)
+{
+  if (result.digits > best.digits)
+  {
+    best.value.set_prec(result.value.get_prec());
+    best = result;
+  }
+}
+
+/**
+ * Runs one of the scalable engines and measures how long its final steps took
+ * The engines' default GMP precision is set for the run and restored afterwards
+ * @param use_machin True for the fixed-point Machin engine, false for binary splitting
+ * @param digits The number of decimal places to calculate
+ * @param cancel_at_deadline True to stop the series at the deadline
+ * @return The result; digits is 0 if the run was cancelled without a usable result
+ */
+static BudgetResult run_engine(bool use_machin, int digits, bool cancel_at_deadline)
+{
+  BudgetResult result;
+  mp_bitcnt_t previous_precision = mpf_get_default_prec();
+
+  CalculationHooks hooks = {record_series_end, cancel_at_deadline ? deadline_passed : nullptr, nullptr};
+  set_calculation_hooks(&hooks);
+  series_end_ms = -1.0;
+  gettimeofday(&run_start, nullptr);
+
+  if (use_machin)
+  {
+    result.text = calculate_pi_machin_fixed_point(digits);
+    result.digits = result.text.empty() ? 0 : digits;
+  }
+  else
+  {
+    // Split into a few segments so a cut-off run still leaves the completed ones
+    mpf_set_default_prec(static_cast<mp_bitcnt_t>(digits * 3.32193) + 64);
+    size_t previous_limit = get_binary_splitting_memory_limit();
+    size_t minimum = estimate_binary_splitting_minimum_bytes(digits);
+    set_binary_splitting_memory_limit(minimum + (estimate_binary_splitting_bytes(digits) - minimum) / BUDGET_BLOCKS);
+
+    int certified = 0;
+    result.value.set_prec(mpf_get_default_prec());
+    result.value = calculate_pi_chudnovsky_binary_splitting(digits, &certified);
+    result.digits = (result.value > 0) ? certified : 0;
+
+    set_binary_splitting_memory_limit(previous_limit);
+  }
+
+  result.milliseconds = elapsed_ms(run_start);
+  result.tail_milliseconds = (series_end_ms >= 0) ? result.milliseconds - series_end_ms : 0.0;
+  set_calculation_hooks(nullptr);
+  mpf_set_default_prec(previous_precision);
+  return result;
+}
+
+/**
+ * Calibrates an engine's cost model with two small runs
+ * @param model The model to fill in (calibration sizes must be set)
+ * @param use_machin Which engine to calibrate
+ * @param best Receives the larger calibration result, the fallback if the main run fails
+ */
+static void calibrate(CostModel &model, bool use_machin, BudgetResult &best)
+{
+  for (int i = 0; i < 2; ++i)
+  {
+    BudgetResult result = run_engine(use_machin, model.calibration_digits[i], false);
+    model.calibration_ms[i] = max(result.milliseconds, 0.01);  // Guard against zero timings under emulation
+    model.tail_fraction = min(result.tail_milliseconds / model.calibration_ms[i], 1.0);
+    keep_if_better(best, result);
+  }
+
+  // Fit the exponent of t = c * d^e, kept within the range the engines can actually have
+  model.exponent = log(model.calibration_ms[1] / model.calibration_ms[0]) /
+                   log(static_cast<double>(model.calibration_digits[1]) / model.calibration_digits[0]);
+  model.exponent = min(max(model.exponent, 1.0), 2.5);
+}
+
+/**
+ * Predicts the largest precision an engine finishes within the given time
+ * @param model The calibrated cost model
+ * @param milliseconds The time available
+ * @return The predicted number of decimal places, at most INT_MAX
+ */
+static int predict_digits(const CostModel &model, double milliseconds)
+{
+  double ratio = milliseconds / model.calibration_ms[1];
+  double digits = model.calibration_digits[1] * pow(ratio, 1.0 / model.exponent);
+
+  // Clamp before the conversion: a long budget or a fast calibration can overflow an int
+  return static_cast<int>(min(max(digits, 0.0), static_cast<double>(INT_MAX)));
+}
+
+/**
+ * Prints the start and end of a result
+ * @param result The result to show
+ */
+static void show_result(const BudgetResult &result)
+{
+  int shown = min(result.digits, SHOWN_DIGITS);
+  string head, tail;
+
+  if (!result.text.empty())
+  {
+    head = result.text.substr(0, shown + 2);
+    tail = result.text.substr(result.text.size() - shown);
+  }
+  else
+  {
+    // Windowed conversion: only the digits shown are converted, not the whole result
+    head = "3." + extract_decimal_digits(result.value, 0, shown);
+    tail = extract_decimal_digits(result.value, result.digits - shown, shown);
+  }
+
+  cout << "First digits: " << head << endl;
+  cout << "Last digits:  ..." << tail << endl;
+}
+
+/**
+ * Checks a calculated result against the reference and saves it to the SD card through the
+ * background writer, and to the digit cache if it matched
+ * @param result The result to save
+ * @param from_cache True if the result was read from the digit cache (it is neither checked nor stored again)
+ */
+static void save_result(const BudgetResult &result, bool from_cache)
+{
+  string digits = result.text;
+  if (digits.empty())
+  {
+    mp_exp_t exponent;
+    digits = result.value.get_str(exponent, 10, result.digits + 1 + CONVERSION_GUARD_DIGITS);
+    digits.insert(1, ".");
+    digits.resize(result.digits + 2, '0');
+  }
+
+  // The deadline has passed, so nothing is recomputed: only the built-in digits (or a longer
+  // cached reference) are compared before the result is cached for later requests
+  if (!from_cache && compare_pi_digits(digits.c_str(), result.digits) &&
+      digit_cache_store(result.text.empty() ? 8 : 7, digits))
+  {
+    cout << "Cached " << result.digits << " digit(s) for later runs" << endl;
+  }
+
+  string path = string(output_storage_root()) + "/pi_digits.txt";
+  OutputWriter *writer = output_writer_open(path.c_str(), false, digits.size() + 1);
+  if (!writer)
+  {
+    return;
+  }
+
+  output_writer_write(writer, digits.data(), digits.size());
+  output_writer_write(writer, "\n", 1);
+
+  OutputWriterStats stats;
+  if (output_writer_close(writer, &stats))
+  {
+    cout << "Saved " << stats.bytes_written << " byte(s) to " << path << " (" << stats.megabytes_per_second << " MB/s)" << endl;
+  }
+}
+
+/**
+ * Calculates as many digits of Pi as possible within a time budget
+ * Both scalable engines are calibrated with two small runs to fit a cost model, the one
+ * predicted to reach the most digits runs at that precision (capped by free memory), and
+ * its series is cancelled early enough for the final steps to finish by the deadline (the
+ * calibration measures their share of a run). If the run is cut off, the best certified
+ * result is kept: the completed binary splitting segments, or else the largest calibration run.
+ * A digit cache entry that reaches the target replaces the main run
+ * @param budget_seconds The time budget in seconds
+ */
+void run_time_budget(int budget_seconds)
+{
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Time Budget: as many digits as possible in " << budget_seconds << " second(s)" << endl;
+
+  struct timeval start;
+  gettimeofday(&start, nullptr);
+
+  // Calibrate both engines (their time counts against the budget)
+  cout << "Calibrating cost models..." << endl;
+  BudgetResult best;
+  best.digits = 0;
+  CostModel machin = {"Machin's Formula (Base 10^9 Fixed-Point)", {500, 2000}, {0, 0}, 2.0, 0.0};
+  CostModel chudnovsky = {"Chudnovsky Algorithm (Binary Splitting)", {2000, 8000}, {0, 0}, 1.5, 0.0};
+  calibrate(machin, true, best);
+  calibrate(chudnovsky, false, best);
+
+  // Predict what each engine reaches in the remaining time, within the memory available
+  double remaining_ms = (budget_seconds * 1000.0 - elapsed_ms(start)) * BUDGET_SAFETY;
+  int memory_cap = static_cast<int>(min<size_t>(sample_heap().largest_free_block / BYTES_PER_DIGIT, 0x7FFFFFFF));
+  int machin_digits = min(predict_digits(machin, remaining_ms), memory_cap);
+  int chudnovsky_digits = min(predict_digits(chudnovsky, remaining_ms), memory_cap);
+
+  cout << machin.name << ": t ~ d^" << machin.exponent << ", predicts " << machin_digits << " digits" << endl;
+  cout << chudnovsky.name << ": t ~ d^" << chudnovsky.exponent << ", predicts " << chudnovsky_digits << " digits" << endl;
+
+  bool use_machin = machin_digits > chudnovsky_digits;
+  int target = max(use_machin ? machin_digits : chudnovsky_digits, best.digits);
+
+  // A cached result that reaches the target answers the budget without the main run
+  BudgetResult result;
+  result.digits = 0;
+  size_t cached = min<size_t>(digit_cache_available(), memory_cap);
+  struct timeval read_start;
+  gettimeofday(&read_start, nullptr);
+  bool from_cache = cached >= static_cast<size_t>(target) && digit_cache_lookup(cached, result.text);
+  if (from_cache)
+  {
+    result.digits = static_cast<int>(cached);
+    result.milliseconds = elapsed_ms(read_start);
+    result.tail_milliseconds = 0.0;
+    cout << "Read " << cached << " digits from the digit cache in " << result.milliseconds << " ms." << endl;
+  }
+  else
+  {
+    cout << "Running " << (use_machin ? machin.name : chudnovsky.name) << " for " << target << " digits..." << endl;
+
+    // The final steps run to completion even after a cancel, so the series stops their
+    // predicted time ahead of the budget (the run is sized to take about remaining_ms)
+    double tail_ms = (use_machin ? machin.tail_fraction : chudnovsky.tail_fraction) * remaining_ms;
+    deadline = offset_time(start, budget_seconds * 1000.0 - tail_ms);
+    cout << "Final steps predicted at " << tail_ms << " ms; the series stops that long before the deadline" << endl;
+
+    // Main run, cancelled at the deadline (the assignment keeps the result's precision)
+    BudgetResult run = run_engine(use_machin, target, true);
+    result.value.set_prec(run.value.get_prec());
+    result = run;
+  }
+
+  if (from_cache || result.digits == target)
+  {
+    cout << "Finished within the budget." << endl;
+  }
+  else if (result.digits > 0)
+  {
+    cout << "Deadline reached; keeping the completed segments." << endl;
+  }
+  else
+  {
+    cout << "Deadline reached; falling back to the calibration result." << endl;
+  }
+
+  keep_if_better(best, result);
+
+  cout << "\nCertified digits: " << best.digits << " in " << elapsed_ms(start) / 1000.0 << " second(s)" << endl;
+  show_result(best);
+  save_result(best, from_cache);
+}
+
+// EOF
@@ -17,81 +17,163 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "utility.hpp"
-#include "input.hpp"
+#include "kernels.hpp"
+#include "binary_splitting.hpp"
+#include "digit_cache.hpp"
+#include "bbp_digits.hpp"
 #include <iostream>
-#include <time.h>
-#include <unistd.h>
 #include <cstdio>
 #include <cstdlib>
-#include <ogcsys.h>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
 
 using namespace std;  // Use the entire std namespace for simplicity
 
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL  // 64-bit FNV-1a parameters
+#define FNV_PRIME 0x100000001B3ULL
+#define WINDOW_GUARD_BITS 64  // Bits kept below a digit window, so truncating the value cannot reach the window
+#define SPOT_CHECKS 3  // BBP spot checks of a long binary result
+#define SPOT_CHECK_GUARD_DIGITS 4  // Hex places kept clear of the end of the result's precision
+
+// Farthest hex position spot checked; the extraction costs about position * log2(position)
+// modular steps (roughly 0.5 s at this limit on either platform)
+#ifdef GEKKO
+#define SPOT_CHECK_MAX_POSITION 20000
+#else
+#define SPOT_CHECK_MAX_POSITION 250000
+#endif
+
 /**
- * Exits the program and attempts to return to the Homebrew Channel or system menu
- * Always waits for 3 seconds before exiting
+ * Formats the Pi value into a string with a specified number of decimal places
+ * @param pi_value The Pi value to format
+ * @param precision Number of decimal places to format Pi
+ * @return "3." followed by the (truncated, not rounded) decimal places
  */
-void exit_WPCPP()
+string format_pi(const mpf_class &pi_value, int precision)
 {
-  // Print exit message
-  cout << "\nExiting to Homebrew Channel..." << endl;
+  // Convert guard digits beyond the precision, so get_str's rounding cannot carry into
+  // the last kept digit (one extra digit is not enough: 3.14159265358|979 rounds up)
+  mp_exp_t exp;
+  string pi_str = pi_value.get_str(exp, 10, precision + 1 + CONVERSION_GUARD_DIGITS);
 
-  // Wait for 3 seconds before exiting
-  struct timespec req = {3, 0};  // 3 seconds sleep
-  nanosleep(&req, nullptr);
+  // Insert the decimal point after the first digit
+  pi_str.insert(1, ".");
 
-  // Reset the system and return to Homebrew Channel (or system menu if Homebrew isn't available)
-  SYS_ResetSystem(SYS_RETURNTOMENU, 0, 0);
+  // Truncate to exactly the precision we want (removing the extra digit)
+  if (pi_str.length() > static_cast<std::string::size_type>(precision + 2))  // +2 for "3."
+  {
+    pi_str.resize(precision + 2);
+  }
 
-  // Fallback in case the system reset fails
-  exit(1);
+  return pi_str;
 }
 
-void wait_for_user_input_to_return()
+/**
+ * Computes reference digits of Pi after the point with the binary splitting engine,
+ * using guard digits so the last requested digit is not affected by rounding
+ * @param count The number of digits
+ * @param hexadecimal True for base 16 (lowercase), false for base 10
+ * @return The digits, without the leading "3."
+ */
+string compute_reference_digits(size_t count, bool hexadecimal)
 {
-    std::cout << "Press any button to return to the menu." << std::endl;
-    while (true)
-    {
-      // Update the input states
-      poll_inputs();
+  int precision = static_cast<int>(hexadecimal ? count * 1.20412 : count) + 16;  // log(16) / log(10)
+  mp_bitcnt_t previous_precision = mpf_get_default_prec();
+  mpf_set_default_prec(static_cast<mp_bitcnt_t>(precision * 3.32193) + 64);
 
-      // Check if any button on the GameCube controller or Wii Remote is pressed
-      if (is_button_just_pressed(0xFFFFFFFF, 0xFFFFFFFF))
-      {
-        break;
-      }
-
-      // Wait for video sync to ensure smooth input handling
-      VIDEO_WaitVSync();
-    }
+  mpf_class pi = calculate_pi_chudnovsky_binary_splitting(precision);
+  mp_exp_t exponent;
+  string digits = pi.get_str(exponent, hexadecimal ? 16 : 10, count + 8);
+  digits = digits.substr(1, count);  // Drop the leading 3 and the rounded tail
+  mpf_set_default_prec(previous_precision);
+  return digits;
 }
 
 /**
- * Formats the Pi value into a string with a specified number of decimal places
- * @param pi_value The Pi value to format
- * @param pi_str The string buffer where the formatted Pi will be stored
- * @param precision Number of decimal places to format Pi
+ * Extracts the decimal digits [first, first + count) after the decimal point of a
+ * binary fixed-point number without converting the whole number to a string
+ * The fractional part x is shifted left by 'first' decimal places by multiplying it with
+ * 10^first (mod 1). Since 10^first = 2^first * 5^first, this only needs 5^first reduced
+ * modulo 2^fraction_bits and a shift, so every operand stays fraction_bits long
+ * Only the top (first + count) * log2(10) bits of the fraction (plus guard bits) reach the
+ * window, so the fraction is truncated to them first: the cost follows the window's
+ * position, not the size of the value
+ * The window must lie within the accuracy of the value: first + count should stay a few
+ * digits below fraction_bits * log10(2)
+ * @param fixed_value The number scaled by 2^fraction_bits (only the fractional bits are used)
+ * @param fraction_bits The number of fractional bits in fixed_value
+ * @param first Index of the first digit after the decimal point to extract (0 is the first decimal)
+ * @param count The number of digits to extract
+ * @return The requested digits as a string of exactly 'count' characters
  */
-void format_pi(const mpf_class &pi_value, char *pi_str, int precision)
+string extract_decimal_digits(const mpz_class &fixed_value, mp_bitcnt_t fraction_bits, unsigned long first, unsigned long count)
 {
-  // Work with one extra digit of precision to handle rounding properly
-  int working_precision = precision + 1;
+  if (count == 0)
+  {
+    return string();
+  }
 
-  // Convert with extra precision
-  mp_exp_t exp;
-  string pi_str_raw = pi_value.get_str(exp, 10, working_precision + 1);
+  // Keep the fractional bits down to the window (and the guard bits below it)
+  mpz_class fraction;
+  mpz_fdiv_r_2exp(fraction.get_mpz_t(), fixed_value.get_mpz_t(), fraction_bits);
+  mp_bitcnt_t window_bits = static_cast<mp_bitcnt_t>((first + count) * 3.32193) + WINDOW_GUARD_BITS;
+  if (window_bits < fraction_bits)
+  {
+    mpz_fdiv_q_2exp(fraction.get_mpz_t(), fraction.get_mpz_t(), fraction_bits - window_bits);
+    fraction_bits = window_bits;
+  }
 
-  // Insert the decimal point after the first digit
-  pi_str_raw.insert(1, ".");
+  mpz_class window;  // The fractional part of 10^first * x, scaled by 2^fraction_bits
+  mpz_class modulus = 1;
+  mpz_mul_2exp(modulus.get_mpz_t(), modulus.get_mpz_t(), fraction_bits);
 
-  // Truncate to exactly the precision we want (removing the extra digit)
-  if (pi_str_raw.length() > static_cast<std::string::size_type>(precision + 2))  // +2 for "3."
+  // 5^first mod 2^fraction_bits, multiplied into the fractional bits of x
+  mpz_class five = 5;
+  mpz_powm_ui(window.get_mpz_t(), five.get_mpz_t(), first, modulus.get_mpz_t());
+  mpz_mul(window.get_mpz_t(), window.get_mpz_t(), fraction.get_mpz_t());
+  mpz_fdiv_r_2exp(window.get_mpz_t(), window.get_mpz_t(), fraction_bits);
+
+  // The remaining 2^first factor is a shift, again reduced mod 1
+  mpz_mul_2exp(window.get_mpz_t(), window.get_mpz_t(), first);
+  mpz_fdiv_r_2exp(window.get_mpz_t(), window.get_mpz_t(), fraction_bits);
+
+  // The next 'count' digits are floor(window * 10^count / 2^fraction_bits)
+  mpz_class scale;
+  mpz_ui_pow_ui(scale.get_mpz_t(), 10, count);
+  mpz_mul(window.get_mpz_t(), window.get_mpz_t(), scale.get_mpz_t());
+  mpz_fdiv_q_2exp(window.get_mpz_t(), window.get_mpz_t(), fraction_bits);
+
+  // Pad with the leading zeros that the integer conversion drops
+  string digits = window.get_str(10);
+  if (digits.size() < count)
   {
-    pi_str_raw = pi_str_raw.substr(0, precision + 2);
+    digits.insert(0, count - digits.size(), '0');
   }
+  return digits;
+}
 
-  // Copy to output buffer
-  snprintf(pi_str, TOTAL_LENGTH, "%s", pi_str_raw.c_str());
+/**
+ * Extracts the decimal digits [first, first + count) after the decimal point of a
+ * floating-point value, using its mantissa bits down to the window as the fixed-point fraction
+ * @param value The value to extract digits from (must be non-negative)
+ * @param first Index of the first digit after the decimal point to extract (0 is the first decimal)
+ * @param count The number of digits to extract
+ * @return The requested digits as a string of exactly 'count' characters
+ */
+string extract_decimal_digits(const mpf_class &value, unsigned long first, unsigned long count)
+{
+  // Only the bits down to the window are converted; the mpz overload truncates the same way
+  mp_bitcnt_t window_bits = static_cast<mp_bitcnt_t>((first + count) * 3.32193) + WINDOW_GUARD_BITS;
+  mp_bitcnt_t fraction_bits = min<mp_bitcnt_t>(value.get_prec(), window_bits);
+
+  // Scaling by a power of two only changes the exponent, so this conversion is exact up
+  // to the truncation to fraction_bits
+  mpf_class scaled(0, fraction_bits + GMP_NUMB_BITS);
+  mpf_mul_2exp(scaled.get_mpf_t(), value.get_mpf_t(), fraction_bits);
+
+  mpz_class fixed_value(scaled);
+  return extract_decimal_digits(fixed_value, fraction_bits, first, count);
 }
 
 /**
@@ -99,81 +181,183 @@ void format_pi(const mpf_class &pi_value, char *pi_str, int precision)
  * This function prints the comparison result and identifies the first mismatched digit (if any)
  * @param calculated_pi The Pi value calculated by the program
  * @param precision The number of decimal places to compare
+ * @return True if all the digits are correct
  */
-void compare_pi_accuracy(const mpf_class &calculated_pi, int precision)
+bool compare_pi_accuracy(const mpf_class &calculated_pi, int precision)
 {
   if (calculated_pi <= 0)
   {
     cout << "Invalid input: Pi cannot be less than or equal to zero." << endl;
-    return;
+    return false;
   }
 
-  // Buffers for the calculated Pi string
-  char calculated_str[TOTAL_LENGTH];
-
   // Format the calculated Pi string with truncation instead of rounding
-  format_pi(calculated_pi, calculated_str, precision);
+  string calculated_str = format_pi(calculated_pi, precision);
+
+  // Compare the formatted digits against the reference
+  return compare_pi_digits(calculated_str.c_str(), precision);
+}
+
+/**
+ * Prints one line of a comparison, limited to DISPLAY_DIGITS digits starting at 'start'
+ * Cut-off parts are marked with "...", so long results still fit on the screen
+ * @param label The label printed before the digits
+ * @param pi_str The full Pi string
+ * @param start Index of the first character to print
+ */
+static void print_pi_window(const char *label, const char *pi_str, size_t start)
+{
+  size_t length = strlen(pi_str);
+  start = min(start, length);
+  size_t shown = min(length - start, static_cast<size_t>(DISPLAY_DIGITS + 2));
 
+  cout << label << (start > 0 ? "..." : "") << string(pi_str + start, shown)
+       << (start + shown < length ? "..." : "") << endl;
+}
+
+/**
+ * Compares an already formatted "3.14159..." string with the actual Pi value
+ * (up to the specified precision). Engines that produce decimal digits directly
+ * use this to skip the binary-to-decimal conversion done by format_pi
+ * Beyond the PI_DIGITS built-in places, the reference is read from the digit cache; without
+ * a cached one only the built-in places are compared (recomputing a reference would cost as
+ * much as the calculation, and with binary splitting it would check the engine with itself)
+ * @param calculated_str The calculated Pi value as a decimal string
+ * @param precision The number of decimal places in the calculated value
+ * @return True if all the compared digits are correct
+ */
+bool compare_pi_digits(const char *calculated_str, int precision)
+{
   // Pi with up to 100 decimal places
   const char *pi_digits = "3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679";
 
-  // Create a buffer for the reference Pi truncated to exact precision
-  char actual_pi_str[TOTAL_LENGTH];
-  snprintf(actual_pi_str, precision + 3, "%s", pi_digits);  // +3 for null terminator after "3." + precision digits
+  // The reference Pi truncated to exact precision, or to the built-in places if no longer one is cached
+  int compared = precision;
+  string actual_pi_str;
+  if (precision > PI_DIGITS && !digit_cache_lookup(precision, actual_pi_str))
+  {
+    compared = PI_DIGITS;
+  }
+  if (compared <= PI_DIGITS)
+  {
+    actual_pi_str.assign(pi_digits, compared + 2);
+  }
 
-  cout << "Comparing calculated Pi to the actual value of Pi (up to " << precision << " decimal places)" << endl;
+  cout << "Comparing calculated Pi to the actual value of Pi (up to " << compared << " decimal places)" << endl;
 
   // Verify the basic format first
   if (strncmp(calculated_str, "3.", 2) != 0)
   {
-    cout << "Actual Pi:     " << actual_pi_str << endl;
-    cout << "Calculated Pi: " << calculated_str << endl;
+    print_pi_window("Actual Pi:     ", actual_pi_str.c_str(), 0);
+    print_pi_window("Calculated Pi: ", calculated_str, 0);
     cout << "None of the digits are correct!" << endl;
-    return;
+    return false;
   }
 
-  // Compare digits after decimal point
-  bool exact_match = true;
-  int mismatch_index = 2;  // Start after "3."
+  // Compare digits after the decimal point, up to the end of the shorter string
+  size_t compare_length = min(static_cast<size_t>(compared + 2), min(strlen(calculated_str), actual_pi_str.size()));
+  int mismatch_index = 2 + static_cast<int>(kernels.first_mismatch(calculated_str + 2, actual_pi_str.c_str() + 2, compare_length - 2));  // Start after "3."
 
-  while (mismatch_index < precision + 2 && calculated_str[mismatch_index] && actual_pi_str[mismatch_index])
+  // Output results
+  if (mismatch_index == compared + 2)
   {
-    if (calculated_str[mismatch_index] != actual_pi_str[mismatch_index])
+    print_pi_window("Actual Pi:     ", actual_pi_str.c_str(), 0);
+    print_pi_window("Calculated Pi: ", calculated_str, 0);
+    cout << "All " << compared << " digit(s) after the decimal are correct!" << endl;
+    if (compared < precision)
     {
-      exact_match = false;
-      break;
+      cout << "No reference is cached for the other " << precision - compared << " digit(s)." << endl;
     }
-    ++mismatch_index;
+    return true;
   }
 
-  // Output results
-  if (exact_match && mismatch_index == precision + 2)
+  print_mismatch(calculated_str, actual_pi_str.c_str(), mismatch_index);
+  return false;
+}
+
+/**
+ * Returns hexadecimal digits of a binary value at a position after the point
+ * Scaling by a power of two only changes the exponent, so only the integer part up to the
+ * wanted digits is converted
+ * @param value The value
+ * @param position The position of the first digit (1 is the first digit after the point)
+ * @param count The number of digits
+ * @return The digits in lowercase, exactly 'count' characters
+ */
+static string hex_digits_at(const mpf_class &value, uint64_t position, int count)
+{
+  mpf_class scaled(0, value.get_prec());
+  mpf_mul_2exp(scaled.get_mpf_t(), value.get_mpf_t(), 4 * (position - 1 + count));
+  mpz_class digits(scaled);
+  mpz_fdiv_r_2exp(digits.get_mpz_t(), digits.get_mpz_t(), 4 * count);
+
+  string text = digits.get_str(16);
+  transform(text.begin(), text.end(), text.begin(), ::toupper);  // BBP extraction prints upper case
+  return string(count - text.size(), '0') + text;
+}
+
+/**
+ * Spot checks a binary result of Pi against BBP digit extraction, which shares nothing
+ * with the engines, at SPOT_CHECKS hexadecimal positions up to SPOT_CHECK_MAX_POSITION
+ * The extraction's cost grows with the position, so the positions are capped to keep the
+ * check cheap next to the calculation; digits beyond the last position are not checked
+ * @param value The calculated Pi value
+ * @param precision The number of decimal places it was calculated to
+ * @return True if every spot matches
+ */
+bool spot_check_pi(const mpf_class &value, int precision)
+{
+  // Hex places the precision covers (log2(10) / 4 per decimal), less a margin for the last bits
+  uint64_t hex_places = static_cast<uint64_t>(precision * 0.830482);
+  if (hex_places <= BBP_DIGITS + SPOT_CHECK_GUARD_DIGITS)
+  {
+    return true;
+  }
+  uint64_t limit = min<uint64_t>(hex_places - BBP_DIGITS - SPOT_CHECK_GUARD_DIGITS, SPOT_CHECK_MAX_POSITION);
+
+  bool all_match = true;
+  for (int i = SPOT_CHECKS; i >= 1; --i)
   {
-    cout << "Actual Pi:     " << actual_pi_str << endl;
-    cout << "Calculated Pi: " << calculated_str << endl;
-    cout << "All " << precision << " digit(s) after the decimal are correct!" << endl;
+    uint64_t position = max<uint64_t>(limit * i / SPOT_CHECKS, 1);
+    char expected[BBP_DIGITS];
+    bbp_hex_digits(position, expected);
+    string actual = hex_digits_at(value, position, BBP_DIGITS);
+    if (actual.compare(0, BBP_DIGITS, expected, BBP_DIGITS) != 0)
+    {
+      cout << "BBP spot check MISMATCH at hex position " << position << ": expected "
+           << string(expected, BBP_DIGITS) << ", calculated " << actual << endl;
+      all_match = false;
+    }
   }
-  else
+
+  if (all_match)
   {
-    print_mismatch(calculated_str, actual_pi_str, mismatch_index);
+    cout << "BBP spot checks at " << SPOT_CHECKS << " hex position(s) up to " << limit << " match." << endl;
   }
+  return all_match;
 }
 
 /**
  * Prints the location of the first mismatched digit between the calculated
  * Pi string and the actual Pi string
+ * A mismatch beyond the first line is shown in a window of digits around it
  * @param calculated_str The string of the calculated Pi value
  * @param actual_str The string representing the actual Pi value
  * @param mismatch_index The index where the mismatch occurs
  */
 void print_mismatch(const char *calculated_str, const char *actual_str, int mismatch_index)
 {
-  cout << "Actual Pi:     " << actual_str << endl;
-  cout << "Calculated Pi: " << calculated_str << endl;
+  size_t start = mismatch_index < DISPLAY_DIGITS + 2 ? 0 : mismatch_index - DISPLAY_DIGITS / 2;
+  print_pi_window("Actual Pi:     ", actual_str, start);
+  print_pi_window("Calculated Pi: ", calculated_str, start);
 
   // Print an arrow pointing to the first mismatch
   cout << "               ";  // Aligns the arrow with the Pi values
-  for (int i = 0; i < mismatch_index; ++i)
+  if (start > 0)
+  {
+    cout << "   ";  // Skip the "..." in front of the window
+  }
+  for (size_t i = start; i < static_cast<size_t>(mismatch_index); ++i)
   {
     cout << " ";  // Create space for the arrow to point under the mismatched digit
   }
@@ -182,4 +366,21 @@ void print_mismatch(const char *calculated_str, const char *actual_str, int mism
   cout << "First mismatch at: " << (mismatch_index - 1) << " digit(s) after the decimal" << endl;
 }
 
+/**
+ * Hashes digits with 64-bit FNV-1a, used to validate benchmark results and cached digits
+ * @param digits The digits
+ * @param count The number of digits to hash
+ * @return The hash
+ */
+uint64_t hash_digits(const char *digits, size_t count)
+{
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (size_t i = 0; i < count; ++i)
+  {
+    hash ^= static_cast<unsigned char>(digits[i]);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
 // EOF
@@ -20,15 +20,22 @@
 #define UTILITY_HPP
 
 #include <gmpxx.h>
+#include <cstdint>
+#include <string>
 
-#define PI_DIGITS 50  // Number of decimal places of Pi
-#define TOTAL_LENGTH (PI_DIGITS + 3)  // '3.' + digits + null terminator
+#define PI_DIGITS 100  // Decimal places of the built-in reference (longer comparisons use a cached one)
+#define DISPLAY_DIGITS 50  // Decimal places printed per line when showing a comparison
+#define CONVERSION_GUARD_DIGITS 10  // Extra digits converted so get_str's rounding cannot reach the last kept digit
 
-void exit_WPCPP();
-void wait_for_user_input_to_return();
-void format_pi(const mpf_class &pi_value, char *pi_str, int precision);
-void compare_pi_accuracy(const mpf_class &calculated_pi, int precision);
+std::string format_pi(const mpf_class &pi_value, int precision);
+std::string extract_decimal_digits(const mpz_class &fixed_value, mp_bitcnt_t fraction_bits, unsigned long first, unsigned long count);
+std::string extract_decimal_digits(const mpf_class &value, unsigned long first, unsigned long count);
+std::string compute_reference_digits(size_t count, bool hexadecimal);
+bool compare_pi_accuracy(const mpf_class &calculated_pi, int precision);
+bool compare_pi_digits(const char *calculated_str, int precision);
+bool spot_check_pi(const mpf_class &value, int precision);
 void print_mismatch(const char *calculated_str, const char *actual_str, int mismatch_index);
+uint64_t hash_digits(const char *digits, size_t count);
 
 #endif
 
@@ -0,0 +1,304 @@
+// verify.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "verify.hpp"
+#include "kernels.hpp"
+#include "output_writer.hpp"
+#include "digit_cache.hpp"
+#include "utility.hpp"
+#include "bbp_digits.hpp"
+#include <gmpxx.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/time.h>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+#define VERIFY_CHUNK_SIZE (512 * 1024)  // Bytes read from the file at a time
+#define VERIFY_SPOT_MIN_SECONDS 1.0  // Spot check budget for files that stream in less time than this
+#define VERIFY_SPOT_CALIBRATION_POSITION 10000  // Extraction timed to predict the cost of the spot checks
+
+// The reference prefix is computed locally, so its length follows the platform's memory
+#ifdef GEKKO
+#define VERIFY_REFERENCE_DIGITS 100000
+#define VERIFY_SPOT_CHECKS 4
+#else
+#define VERIFY_REFERENCE_DIGITS 1000000
+#define VERIFY_SPOT_CHECKS 8
+#endif
+
+/**
+ * Returns the seconds elapsed since a start time
+ * @param start The start time
+ * @return The elapsed time in seconds
+ */
+static double elapsed_seconds(const struct timeval &start)
+{
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1000000.0;
+}
+
+/**
+ * Checks whether a byte is a digit of the file's base
+ * @param c The byte
+ * @param hexadecimal True for base 16
+ * @return True for a digit
+ */
+static bool is_digit_of(unsigned char c, bool hexadecimal)
+{
+  return hexadecimal ? isxdigit(c) : isdigit(c);
+}
+
+/**
+ * Computes the reference digits after the point, in decimal or hexadecimal
+ * @param count The number of digits
+ * @param hexadecimal True for base 16
+ * @param uppercase True for uppercase hex letters
+ * @return The digits
+ */
+static string compute_reference(size_t count, bool hexadecimal, bool uppercase)
+{
+  string digits = compute_reference_digits(count, hexadecimal);
+  if (uppercase)
+  {
+    transform(digits.begin(), digits.end(), digits.begin(), ::toupper);
+  }
+  return digits;
+}
+
+/**
+ * Verifies a digit file ("3." followed by decimal or hexadecimal digits)
+ * The file is streamed in large chunks: the prefix is compared with a locally computed
+ * reference (or a longer one from the digit cache) using the comparison kernel, every other byte is only checked to be a digit,
+ * so the pass runs at the speed of the storage. Hex files are also checked at positions
+ * spread through the rest of the file by BBP digit extraction, which needs none of the
+ * digits before them. Their cost grows with the position, so they stay below
+ * BBP_MAX_POSITION (where the double-precision sums are trustworthy) and within a
+ * time budget equal to the streaming time, keeping the whole pass bound by the storage
+ * @param path The file to verify, or nullptr for pi_verify.txt in the storage root
+ */
+void run_verifier(const char *path)
+{
+  string default_path = string(output_storage_root()) + "/pi_verify.txt";
+  if (!path)
+  {
+    path = default_path.c_str();
+  }
+
+  cout << "\x1b[2J";  // ANSI escape code to clear the screen
+  cout << "Verifying " << path << endl;
+
+  struct stat info;
+  FILE *file = fopen(path, "rb");
+  if (!file || stat(path, &info) != 0)
+  {
+    cout << "Could not open the file." << endl;
+    if (file)
+    {
+      fclose(file);
+    }
+    return;
+  }
+  setvbuf(file, nullptr, _IONBF, 0);  // Whole chunks are read, so stdio buffering would only add a copy
+
+  // Detect the format from the first digits
+  char *chunk = new char[VERIFY_CHUNK_SIZE];
+  size_t length = fread(chunk, 1, VERIFY_CHUNK_SIZE, file);
+  bool hexadecimal = (length >= 7 && strncasecmp(chunk, "3.243F6", 7) == 0);
+  if (!hexadecimal && (length < 7 || strncmp(chunk, "3.14159", 7) != 0))
+  {
+    cout << "Not a digit file of Pi (expected \"3.14159...\" or \"3.243F6...\")." << endl;
+    delete[] chunk;
+    fclose(file);
+    return;
+  }
+  bool uppercase = hexadecimal && chunk[5] == 'F';
+
+  // The whole file is digits except "3." and possibly a trailing newline
+  uint64_t file_digits = static_cast<uint64_t>(info.st_size) - 2;
+  size_t reference_length = static_cast<size_t>(min<uint64_t>(file_digits, VERIFY_REFERENCE_DIGITS));
+  cout << "Format: " << (hexadecimal ? "hexadecimal" : "decimal") << ", " << file_digits << " byte(s) of digits" << endl;
+
+  // A larger decimal result in the digit cache extends the reference at the cost of reading it
+  struct timeval start;
+  gettimeofday(&start, nullptr);
+  string reference;
+  size_t cached_length = static_cast<size_t>(min<uint64_t>(file_digits, hexadecimal ? 0 : digit_cache_available()));
+  if (cached_length > reference_length && digit_cache_lookup(cached_length, reference))
+  {
+    reference.erase(0, 2);  // Drop "3."
+    reference_length = cached_length;
+    cout << "Reference: " << reference_length << " digit(s) read from the cache in " << elapsed_seconds(start) << " s" << endl;
+  }
+  else
+  {
+    reference = compute_reference(reference_length, hexadecimal, uppercase);
+    cout << "Reference: " << reference_length << " digit(s) computed in " << elapsed_seconds(start) << " s" << endl;
+  }
+
+  // Stream the file: compare the prefix, then only check that the bytes are digits
+  gettimeofday(&start, nullptr);
+  uint64_t position = 0;  // Digits examined so far (position + 1 is the next one)
+  uint64_t digits = 0;  // Length of the digit run (it ends at the first non-digit byte)
+  uint64_t discrepancy = 0;  // Position of the first wrong digit (0 if none)
+  uint64_t bad_byte = 0;  // Position of a non-digit byte followed by more data (0 if none)
+  bool ended = false;
+  uint64_t bytes_read = length;
+  size_t offset = 2;  // Skip "3."
+
+  while (length > offset)
+  {
+    const char *data = chunk + offset;
+    size_t count = length - offset;
+
+    // Prefix comparison with the kernel (only as long as no discrepancy has been found)
+    if (!discrepancy && !ended && position < reference_length)
+    {
+      size_t compare = static_cast<size_t>(min<uint64_t>(count, reference_length - position));
+      size_t mismatch = kernels.first_mismatch(data, reference.data() + position, compare);
+      if (mismatch < compare && is_digit_of(static_cast<unsigned char>(data[mismatch]), hexadecimal))
+      {
+        discrepancy = position + mismatch + 1;
+      }
+    }
+
+    // Digit class check of every byte; trailing whitespace after the digits is allowed
+    for (size_t i = 0; i < count; ++i)
+    {
+      unsigned char c = static_cast<unsigned char>(data[i]);
+      if (!ended && is_digit_of(c, hexadecimal))
+      {
+        digits++;
+      }
+      else if (!ended)
+      {
+        ended = true;
+        if (!isspace(c))
+        {
+          bad_byte = position + i + 1;
+        }
+      }
+      else if (!isspace(c) && !bad_byte)
+      {
+        bad_byte = position + i + 1;
+      }
+    }
+    position += count;
+
+    length = fread(chunk, 1, VERIFY_CHUNK_SIZE, file);
+    bytes_read += length;
+    offset = 0;
+  }
+  double stream_seconds = elapsed_seconds(start);
+  delete[] chunk;
+
+  cout << "Read " << bytes_read << " byte(s) in " << stream_seconds << " s ("
+       << (stream_seconds > 0 ? bytes_read / stream_seconds / (1024.0 * 1024.0) : 0.0) << " MB/s)" << endl;
+
+  // Spot checks spread over the part of a hex file beyond the reference prefix, up to the
+  // trusted range. A check costs about as much as its position, so a short calibration
+  // extraction sets the farthest affordable position; the checks run farthest first (a
+  // wrong calculation stays wrong from its first error on) and are skipped once their
+  // predicted cost exceeds what is left of the budget
+  int spot_failures = 0;
+  int spot_checks = 0;
+  uint64_t spot_limit = (digits > BBP_DIGITS) ? min<uint64_t>(digits - BBP_DIGITS, BBP_MAX_POSITION) : 0;
+  if (hexadecimal && !discrepancy && spot_limit > reference_length)
+  {
+    gettimeofday(&start, nullptr);
+    char calibration[BBP_DIGITS];
+    bbp_hex_digits(VERIFY_SPOT_CALIBRATION_POSITION, calibration);
+    double seconds_per_step = max(elapsed_seconds(start), 1e-6) / bbp_steps(VERIFY_SPOT_CALIBRATION_POSITION);
+    double spot_budget = max(stream_seconds, VERIFY_SPOT_MIN_SECONDS);
+    while (spot_limit > reference_length && elapsed_seconds(start) + seconds_per_step * bbp_steps(spot_limit) > spot_budget)
+    {
+      spot_limit -= spot_limit / 8 + 1;
+    }
+
+    uint64_t span = (spot_limit > reference_length) ? spot_limit - reference_length : 0;
+    for (int i = VERIFY_SPOT_CHECKS; i >= 1 && span; --i)
+    {
+      uint64_t spot = reference_length + span * i / VERIFY_SPOT_CHECKS;
+      if (i < VERIFY_SPOT_CHECKS && elapsed_seconds(start) + seconds_per_step * bbp_steps(spot) > spot_budget)
+      {
+        cout << "Position " << spot << ": skipped (over the time budget)" << endl;
+        continue;
+      }
+      spot_checks++;
+
+      char expected[BBP_DIGITS], actual[BBP_DIGITS];
+      bbp_hex_digits(spot, expected);
+
+      bool match = fseeko(file, static_cast<off_t>(spot + 1), SEEK_SET) == 0 &&  // "3." then position 1 at offset 2
+                   fread(actual, 1, BBP_DIGITS, file) == BBP_DIGITS &&
+                   strncasecmp(actual, expected, BBP_DIGITS) == 0;
+      if (!match)
+      {
+        spot_failures++;
+        if (!discrepancy)
+        {
+          discrepancy = spot;  // Somewhere at or before this position
+        }
+      }
+      cout << "Position " << spot << ": " << string(expected, BBP_DIGITS)
+           << (match ? " ok" : " MISMATCH") << endl;
+    }
+    cout << "Spot checks: " << spot_checks << " in " << elapsed_seconds(start) << " s (budget "
+         << spot_budget << " s, separate from the read time)" << endl;
+  }
+  fclose(file);
+
+  // Summary
+  if (discrepancy && !spot_failures)
+  {
+    cout << "FAILED: first wrong digit at position " << discrepancy << endl;
+  }
+  else if (spot_failures)
+  {
+    cout << "FAILED: spot check mismatch at position " << discrepancy << " (the first error is at or before it)" << endl;
+  }
+  else if (bad_byte)
+  {
+    cout << "FAILED: unexpected character at position " << bad_byte << endl;
+  }
+  else
+  {
+    cout << "OK: " << digits << " digit(s); the first " << min<uint64_t>(digits, reference_length)
+         << " match the reference";
+    if (spot_checks)
+    {
+      cout << " and " << spot_checks << " far position(s) match BBP digit extraction";
+    }
+    if (digits > max<uint64_t>(reference_length, spot_checks ? spot_limit : 0))
+    {
+      cout << " (digits beyond the reference are only checked to be digits)";
+    }
+    cout << endl;
+  }
+}
+
+// EOF
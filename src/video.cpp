@@ -17,7 +17,7 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "video.hpp"
-#include "utility.hpp"
+#include "input.hpp"
 #include <gccore.h>
 #include <ogcsys.h>
 #include <iostream>
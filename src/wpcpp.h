@@ -0,0 +1,89 @@
+// wpcpp.h
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Embeddable C API for computing Pi in-process (link libwpcpp.a, built with 'make lib')
+// Results own their digit buffer: the engines' output is converted directly into it, and
+// wpcpp_get_digits() returns a pointer into it instead of a copy
+// The API is not reentrant: the engines share global callback hooks and set GMP's default
+// precision for the duration of a call, so calls must come from one thread at a time and
+// must not overlap with other GMP code that relies on the default precision
+
+#ifndef WPCPP_H
+#define WPCPP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WPCPP_API_VERSION 1
+
+// Calculation methods (same numbering as the method selection menu)
+enum wpcpp_method{
+  WPCPP_METHOD_NUMERICAL_INTEGRATION = 0,  // Up to 18 digits
+  WPCPP_METHOD_MACHIN = 1,  // Fixed term count, up to 47 digits
+  WPCPP_METHOD_RAMANUJAN = 2,  // Fixed term count, up to 63 digits
+  WPCPP_METHOD_CHUDNOVSKY = 3,  // Fixed term count, up to 55 digits
+  WPCPP_METHOD_GAUSS_LEGENDRE = 4,  // Fixed iteration count, up to 83 digits
+  WPCPP_METHOD_SPIGOT = 5,  // Up to 10 million digits (quadratic time)
+  WPCPP_METHOD_BBP = 6,  // Fixed term count, up to 124 digits
+  WPCPP_METHOD_MACHIN_FIXED_POINT = 7,  // Up to 2^29 digits, GMP-free, decimal output
+  WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING = 8,  // Up to INT_MAX / 8 digits, fastest for large digit counts
+  WPCPP_METHOD_BBP_BINARY_SPLITTING = 9,  // Up to INT_MAX / 8 digits, slower than Chudnovsky by a constant factor
+  WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT = 10  // Up to INT_MAX / 8 digits, AGM on scaled integers
+};
+
+enum wpcpp_status{
+  WPCPP_OK = 0,
+  WPCPP_ERROR_INVALID_ARGUMENT = 1,  // Unknown method, digit count of 0 or above the method's limit, or null output pointer
+  WPCPP_ERROR_CANCELLED = 2,  // The cancel callback stopped the calculation
+  WPCPP_ERROR_OUT_OF_MEMORY = 3,  // An allocation for the calculation or the result buffer failed
+  WPCPP_ERROR_MEMORY_LIMIT = 4  // The binary splitting memory limit is too small for the requested digits
+};
+
+// Called with the completed fraction (0 to 1) of the calculation
+typedef void (*wpcpp_progress_callback)(double fraction, void *user_data);
+
+// Polled during the calculation; return non-zero to cancel it
+typedef int (*wpcpp_cancel_callback)(void *user_data);
+
+struct wpcpp_callbacks{
+  wpcpp_progress_callback progress;  // May be NULL
+  wpcpp_cancel_callback cancel;  // May be NULL
+  void *user_data;  // Passed back to both callbacks
+};
+
+typedef struct wpcpp_result wpcpp_result;  // Opaque result owning the digit buffer
+
+int wpcpp_api_version(void);
+enum wpcpp_status wpcpp_compute(enum wpcpp_method method, size_t digits, const struct wpcpp_callbacks *callbacks,
+                                wpcpp_result **result);
+enum wpcpp_status wpcpp_compute_cached(enum wpcpp_method method, size_t digits, const struct wpcpp_callbacks *callbacks,
+                                       wpcpp_result **result);
+const char *wpcpp_get_digits(const wpcpp_result *result, size_t *length);
+size_t wpcpp_get_precision(const wpcpp_result *result);
+void wpcpp_release(wpcpp_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// EOF
@@ -0,0 +1,335 @@
+// wpcpp_api.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "wpcpp.h"
+#include "pi_calculation.hpp"
+#include "binary_splitting.hpp"
+#include "digit_cache.hpp"
+#include "fixed_point.hpp"
+#include "utility.hpp"
+#include <gmpxx.h>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <string>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+// Largest digit count each method computes correctly, indexed by wpcpp_method. The fixed
+// iteration methods were measured against the reference; the spigot keeps its intermediate
+// values in 32-bit ints, the fixed-point Machin engine needs 2 * digits below FP_MAX_DIVISOR,
+// and the other arbitrary-precision engines keep their 3 * bits final step inside a 32-bit
+// mp_bitcnt_t. Every limit is at most INT_MAX, the engines' precision type
+static const size_t method_digit_limits[] = {
+  18,  // WPCPP_METHOD_NUMERICAL_INTEGRATION
+  47,  // WPCPP_METHOD_MACHIN
+  63,  // WPCPP_METHOD_RAMANUJAN
+  55,  // WPCPP_METHOD_CHUDNOVSKY
+  83,  // WPCPP_METHOD_GAUSS_LEGENDRE
+  10000000,  // WPCPP_METHOD_SPIGOT
+  124,  // WPCPP_METHOD_BBP
+  FP_MAX_DIVISOR / 2,  // WPCPP_METHOD_MACHIN_FIXED_POINT
+  INT_MAX / 8,  // WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING
+  INT_MAX / 8,  // WPCPP_METHOD_BBP_BINARY_SPLITTING
+  INT_MAX / 8  // WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT
+};
+
+// A computed result; the string is the digit buffer handed out by wpcpp_get_digits()
+struct wpcpp_result{
+  string digits;  // "3.14159..." with exactly 'precision' decimal places
+  size_t precision;  // Number of decimal places in digits
+};
+
+/**
+ * Adapts the C progress callback to the engines' hook signature
+ * @param fraction The completed fraction of the calculation
+ * @param user_data The caller's wpcpp_callbacks
+ */
+static void forward_progress(double fraction, void *user_data)
+{
+  const wpcpp_callbacks *callbacks = static_cast<const wpcpp_callbacks *>(user_data);
+  callbacks->progress(fraction, callbacks->user_data);
+}
+
+/**
+ * Adapts the C cancel callback to the engines' hook signature
+ * @param user_data The caller's wpcpp_callbacks
+ * @return True if the caller asked to cancel
+ */
+static bool forward_cancel(void *user_data)
+{
+  const wpcpp_callbacks *callbacks = static_cast<const wpcpp_callbacks *>(user_data);
+  return callbacks->cancel(callbacks->user_data) != 0;
+}
+
+/**
+ * Runs one of the floating-point engines at the requested precision
+ * @param method The calculation method
+ * @param digits The number of decimal places
+ * @return The calculated value of Pi
+ */
+static mpf_class run_float_engine(wpcpp_method method, size_t digits)
+{
+  switch (method)
+  {
+    case WPCPP_METHOD_NUMERICAL_INTEGRATION:
+      return calculate_pi_numerical_integration();
+    case WPCPP_METHOD_MACHIN:
+      return calculate_pi_machin();
+    case WPCPP_METHOD_RAMANUJAN:
+      return calculate_pi_ramanujan();
+    case WPCPP_METHOD_CHUDNOVSKY:
+      return calculate_pi_chudnovsky();
+    case WPCPP_METHOD_GAUSS_LEGENDRE:
+      return calculate_pi_gauss_legendre();
+    case WPCPP_METHOD_SPIGOT:
+      return calculate_pi_spigot(static_cast<int>(digits));
+    case WPCPP_METHOD_BBP:
+      return calculate_pi_bbp();
+    case WPCPP_METHOD_BBP_BINARY_SPLITTING:
+      return calculate_pi_bbp_binary_splitting(static_cast<int>(digits));
+    case WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT:
+      return calculate_pi_gauss_legendre_fixed_point(static_cast<int>(digits));
+    default:
+      return calculate_pi_chudnovsky_binary_splitting(static_cast<int>(digits));
+  }
+}
+
+/**
+ * Runs the engine of a request and converts its result into the result's digit buffer
+ * The engines' default GMP precision is set for the run (the caller restores it)
+ * @param method The calculation method
+ * @param digits The number of decimal places
+ * @param computed Receives the digits; left empty if the engine produced no result
+ */
+static void compute_digits(wpcpp_method method, size_t digits, wpcpp_result *computed)
+{
+  if (method == WPCPP_METHOD_MACHIN_FIXED_POINT)
+  {
+    // Already decimal: the engine's string is moved into the result, not copied
+    computed->digits = calculate_pi_machin_fixed_point(static_cast<int>(digits));
+    return;
+  }
+
+  mpf_set_default_prec(static_cast<mp_bitcnt_t>(digits * 3.32193) + 64);
+  mpf_class pi = run_float_engine(method, digits);
+  if (pi > 0)
+  {
+    // Convert straight into the result buffer one character in, then move the leading 3
+    // in front of the decimal point; the guard digits are truncated, not rounded
+    size_t converted_digits = digits + 1 + CONVERSION_GUARD_DIGITS;
+    computed->digits.resize(converted_digits + 3);  // mpf_get_str needs room for a sign and the terminator
+    mp_exp_t exponent;
+    mpf_get_str(&computed->digits[1], &exponent, 10, converted_digits, pi.get_mpf_t());
+    size_t converted = strlen(&computed->digits[1]);
+    computed->digits[0] = computed->digits[1];
+    computed->digits[1] = '.';
+    computed->digits.resize(min(converted + 1, digits + 2));
+    computed->digits.resize(digits + 2, '0');  // mpf_get_str drops trailing zeros
+  }
+}
+
+/**
+ * Checks the arguments shared by the compute calls
+ * @param method The calculation method
+ * @param digits The number of decimal places
+ * @param result The output pointer
+ * @return True if the method exists and can compute that many correct digits
+ */
+static bool valid_request(wpcpp_method method, size_t digits, wpcpp_result **result)
+{
+  if (!result || digits == 0 || method < WPCPP_METHOD_NUMERICAL_INTEGRATION || method > WPCPP_METHOD_GAUSS_LEGENDRE_FIXED_POINT)
+  {
+    return false;
+  }
+  return digits <= method_digit_limits[method];
+}
+
+/**
+ * Returns the version of this API, bumped on incompatible changes
+ * @return WPCPP_API_VERSION of the library
+ */
+int wpcpp_api_version(void)
+{
+  return WPCPP_API_VERSION;
+}
+
+/**
+ * Computes Pi to the requested number of decimal places
+ * The engines' default GMP precision is set for the call and restored afterwards
+ * Digit counts above what the method computes correctly are rejected as invalid, and a
+ * failed allocation during the calculation is reported as WPCPP_ERROR_OUT_OF_MEMORY
+ * @param method The calculation method
+ * @param digits The number of decimal places to compute
+ * @param callbacks Optional progress and cancellation callbacks (may be NULL)
+ * @param result Receives the result on success; release it with wpcpp_release()
+ * @return WPCPP_OK, or the reason no result was produced
+ */
+wpcpp_status wpcpp_compute(wpcpp_method method, size_t digits, const wpcpp_callbacks *callbacks, wpcpp_result **result)
+{
+  if (!valid_request(method, digits, result))
+  {
+    return WPCPP_ERROR_INVALID_ARGUMENT;
+  }
+  *result = nullptr;
+
+  wpcpp_result *computed = new (nothrow) wpcpp_result();
+  if (!computed)
+  {
+    return WPCPP_ERROR_OUT_OF_MEMORY;
+  }
+  computed->precision = digits;
+
+  // Route the engines' hooks to the caller's callbacks for the duration of the call
+  CalculationHooks hooks = {
+    (callbacks && callbacks->progress) ? forward_progress : nullptr,
+    (callbacks && callbacks->cancel) ? forward_cancel : nullptr,
+    const_cast<wpcpp_callbacks *>(callbacks)
+  };
+  set_calculation_hooks(&hooks);
+  mp_bitcnt_t previous_precision = mpf_get_default_prec();
+
+  // Exceptions must not cross the C boundary, so a failed allocation becomes a status
+  bool out_of_memory = false;
+  try
+  {
+    compute_digits(method, digits, computed);
+  }
+  catch (const bad_alloc &)
+  {
+    out_of_memory = true;
+  }
+
+  bool cancelled = calculation_cancelled();
+  set_calculation_hooks(nullptr);
+  mpf_set_default_prec(previous_precision);
+
+  if (out_of_memory || cancelled || computed->digits.empty())
+  {
+    delete computed;
+    if (out_of_memory)
+    {
+      return WPCPP_ERROR_OUT_OF_MEMORY;
+    }
+    if (cancelled)
+    {
+      return WPCPP_ERROR_CANCELLED;
+    }
+    return WPCPP_ERROR_MEMORY_LIMIT;  // Only the binary splitting memory limit makes an engine refuse a valid request
+  }
+
+  *result = computed;
+  return WPCPP_OK;
+}
+
+/**
+ * Like wpcpp_compute(), but answers from the on-disk digit cache when it already holds
+ * at least the requested precision (verified by checksum), and caches new results of
+ * the arbitrary-precision methods (WPCPP_METHOD_MACHIN_FIXED_POINT and up)
+ * @param method The calculation method, used if the digits have to be computed
+ * @param digits The number of decimal places to compute
+ * @param callbacks Optional progress and cancellation callbacks (may be NULL)
+ * @param result Receives the result on success; release it with wpcpp_release()
+ * @return WPCPP_OK, or the reason no result was produced
+ */
+wpcpp_status wpcpp_compute_cached(wpcpp_method method, size_t digits, const wpcpp_callbacks *callbacks, wpcpp_result **result)
+{
+  if (!valid_request(method, digits, result))
+  {
+    return WPCPP_ERROR_INVALID_ARGUMENT;
+  }
+
+  wpcpp_result *cached = new (nothrow) wpcpp_result();
+  if (!cached)
+  {
+    return WPCPP_ERROR_OUT_OF_MEMORY;
+  }
+
+  // The cache is optional, so a failed allocation while reading or storing just skips it
+  bool hit = false;
+  try
+  {
+    hit = digit_cache_lookup(digits, cached->digits);
+  }
+  catch (const bad_alloc &)
+  {
+    hit = false;  // Computed instead, like any other miss
+  }
+  if (hit)
+  {
+    cached->precision = digits;
+    *result = cached;
+    return WPCPP_OK;
+  }
+  delete cached;
+
+  wpcpp_status status = wpcpp_compute(method, digits, callbacks, result);
+  if (status == WPCPP_OK && method >= WPCPP_METHOD_MACHIN_FIXED_POINT)
+  {
+    try
+    {
+      digit_cache_store(method, (*result)->digits);
+    }
+    catch (const bad_alloc &)
+    {
+      // The result is still returned, only not cached
+    }
+  }
+  return status;
+}
+
+/**
+ * Returns a pointer into the result's digit buffer ("3.14159...", NUL-terminated)
+ * The pointer stays valid until the result is released
+ * @param result The result
+ * @param length Receives the number of characters, excluding the terminator (may be NULL)
+ * @return The digits, or NULL if result is NULL
+ */
+const char *wpcpp_get_digits(const wpcpp_result *result, size_t *length)
+{
+  if (!result)
+  {
+    return nullptr;
+  }
+  if (length)
+  {
+    *length = result->digits.size();
+  }
+  return result->digits.c_str();
+}
+
+/**
+ * Returns the number of decimal places in a result
+ * @param result The result
+ * @return The number of decimal places, or 0 if result is NULL
+ */
+size_t wpcpp_get_precision(const wpcpp_result *result)
+{
+  return result ? result->precision : 0;
+}
+
+/**
+ * Frees a result and its digit buffer
+ * @param result The result to free (may be NULL)
+ */
+void wpcpp_release(wpcpp_result *result)
+{
+  delete result;
+}
+
+// EOF
@@ -0,0 +1,196 @@
+// host_test.cpp
+//
+//  Wii Pi Calculator Project Plus (WPCPP)
+//  Copyright (C) 2024 DeltaResero
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Host test of the code that only exists off the Wii (make host-test): the threaded
+// multiply and division are checked against GMP at every split depth, and every kernel
+// variant the CPU supports against the scalar ones; the C API's status codes are checked too
+
+#include "parallel_arithmetic.hpp"
+#include "kernels.hpp"
+#include "binary_splitting.hpp"
+#include "wpcpp.h"
+#include <gmp.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;  // Use the entire std namespace for simplicity
+
+static int failures = 0;  // Checks that failed so far
+
+/**
+ * Records the outcome of one check and prints it when it failed
+ * @param passed True if the check passed
+ * @param what A description of the check
+ */
+static void check(bool passed, const string &what)
+{
+  if (!passed)
+  {
+    cout << "FAIL: " << what << endl;
+    ++failures;
+  }
+}
+
+/**
+ * Checks parallel_mpz_mul and parallel_mpz_tdiv_q against GMP for operands around
+ * and well above the threading threshold, including negative and aliased operands
+ * @param threads The thread count to test with (1, 3 and 9 reach split depths 0, 1 and 2)
+ * @param state The random state for the operands
+ */
+static void test_parallel_arithmetic(int threads, gmp_randstate_t state)
+{
+  static const int sizes[] = {PARALLEL_THRESHOLD_LIMBS / 2, PARALLEL_THRESHOLD_LIMBS + 1, 8 * PARALLEL_THRESHOLD_LIMBS};
+  set_parallel_threads(threads);
+
+  mpz_t a, b, expected, actual;
+  mpz_inits(a, b, expected, actual, nullptr);
+
+  for (int limbs : sizes)
+  {
+    string label = to_string(threads) + " thread(s), " + to_string(limbs) + " limbs";
+
+    mpz_urandomb(a, state, limbs * GMP_NUMB_BITS);
+    mpz_urandomb(b, state, (limbs - 7) * GMP_NUMB_BITS);
+    mpz_mul(expected, a, b);
+    parallel_mpz_mul(actual, a, b);
+    check(mpz_cmp(expected, actual) == 0, "multiply, " + label);
+
+    mpz_neg(b, b);
+    mpz_mul(expected, a, b);
+    parallel_mpz_mul(actual, a, b);
+    check(mpz_cmp(expected, actual) == 0, "negative multiply, " + label);
+
+    mpz_mul(expected, a, a);
+    mpz_set(actual, a);
+    parallel_mpz_mul(actual, actual, actual);
+    check(mpz_cmp(expected, actual) == 0, "aliased square, " + label);
+
+    // A dividend of twice the divisor's size, as in the engines' final division
+    mpz_abs(b, b);
+    mpz_mul(a, a, a);
+    mpz_add_ui(a, a, 12345);
+    mpz_tdiv_q(expected, a, b);
+    parallel_mpz_tdiv_q(actual, a, b);
+    check(mpz_cmp(expected, actual) == 0, "divide, " + label);
+
+    mpz_neg(a, a);
+    mpz_tdiv_q(expected, a, b);
+    parallel_mpz_tdiv_q(actual, a, b);
+    check(mpz_cmp(expected, actual) == 0, "negative divide, " + label);
+  }
+
+  mpz_clears(a, b, expected, actual, nullptr);
+}
+
+/**
+ * Checks every kernel variant the CPU supports against the scalar variant, with
+ * mismatches at each offset around the vector widths and with edge-case words
+ * @param level The kernel level to test
+ */
+static void test_kernels(KernelLevel level)
+{
+  string label = kernel_level_name(level);
+  check(initialize_kernels(label.c_str()) && kernels.level == level, "select " + label);
+
+  // Lengths and mismatch positions straddle the 4, 16, 32 and 64 byte blocks
+  char a[300], b[300];
+  for (size_t i = 0; i < sizeof(a); ++i)
+  {
+    a[i] = b[i] = static_cast<char>('0' + rand() % 10);
+  }
+  for (size_t length = 0; length <= 200; ++length)
+  {
+    check(kernels.first_mismatch(a + 1, b + 1, length) == length, label + " match of length " + to_string(length));
+    for (size_t at = 0; at < length; at += 1 + at / 16)
+    {
+      b[1 + at] ^= 1;
+      check(kernels.first_mismatch(a + 1, b + 1, length) == at,
+            label + " mismatch at " + to_string(at) + " of " + to_string(length));
+      b[1 + at] ^= 1;
+    }
+  }
+
+  uint32_t words[64] = {0, 1, 9, 10, 99999999, 100000000, 123456789, 999999999};
+  for (int i = 8; i < 64; ++i)
+  {
+    words[i] = static_cast<uint32_t>(rand()) % 1000000000;
+  }
+  char expected[64 * 9 + 1], actual[64 * 9];
+  for (int i = 0; i < 64; ++i)
+  {
+    snprintf(expected + 9 * i, 10, "%09u", words[i]);
+  }
+  kernels.words_to_ascii(words, 64, actual);
+  check(string(expected, sizeof(actual)) == string(actual, sizeof(actual)), label + " digit conversion");
+}
+
+/**
+ * Checks that the C API reports a result, an invalid request and a run refused by the
+ * binary splitting memory limit with their own status codes
+ */
+static void test_api_status()
+{
+  wpcpp_result *result = nullptr;
+  check(wpcpp_compute(WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING, 1000, nullptr, &result) == WPCPP_OK &&
+        strncmp(wpcpp_get_digits(result, nullptr), "3.14159265358979323846", 22) == 0, "API result");
+  wpcpp_release(result);
+
+  check(wpcpp_compute(WPCPP_METHOD_MACHIN, 48, nullptr, &result) == WPCPP_ERROR_INVALID_ARGUMENT, "API invalid argument");
+
+  size_t previous_limit = get_binary_splitting_memory_limit();
+  set_binary_splitting_memory_limit(1);
+  check(wpcpp_compute(WPCPP_METHOD_CHUDNOVSKY_BINARY_SPLITTING, 1000, nullptr, &result) == WPCPP_ERROR_MEMORY_LIMIT,
+        "API memory limit");
+  set_binary_splitting_memory_limit(previous_limit);
+}
+
+/**
+ * Runs every host test
+ * @return 0 if all of them passed, 1 otherwise
+ */
+int main()
+{
+  gmp_randstate_t state;
+  gmp_randinit_default(state);
+  gmp_randseed_ui(state, 314159);
+
+  for (int threads : {1, 3, 9})
+  {
+    test_parallel_arithmetic(threads, state);
+  }
+  set_parallel_threads(0);
+
+  srand(271828);
+  for (int level = KERNEL_LEVEL_SCALAR; level <= detect_kernel_level(); ++level)
+  {
+    test_kernels(static_cast<KernelLevel>(level));
+  }
+  initialize_kernels(nullptr);
+
+  test_api_status();
+
+  gmp_randclear(state);
+  cout << (failures == 0 ? "All host tests passed" : to_string(failures) + " host test(s) failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
+
+// EOF